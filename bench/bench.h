@@ -0,0 +1,40 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <time.h>
+
+/// @file
+///
+/// Helpers shared by the benchmarks.
+
+/// @return The current time, in seconds.
+[[nodiscard]] static inline double bench_time(void) {
+    struct timespec ts;
+    timespec_get(&ts, TIME_UTC);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1.0e-9;
+}
+
+/// @cond PRIVATE
+static volatile uint64_t bench_sink;
+/// @endcond
+
+/// Prevents the compiler from optimizing away the computation of the given value.
+static inline void bench_use(uint64_t x) {
+    bench_sink = x;
+}
+
+/// Produces a sequence of distinct, well-distributed 64-bit numbers (SplitMix64 generator).
+[[nodiscard]] static inline uint64_t bench_key(uint64_t i) {
+    uint64_t z = (i + 1) * UINT64_C(0x9e3779b97f4a7c15);
+    z = (z ^ (z >> 30)) * UINT64_C(0xbf58476d1ce4e5b9);
+    z = (z ^ (z >> 27)) * UINT64_C(0x94d049bb133111eb);
+    return z ^ (z >> 31);
+}
+
+/// Prints one benchmark result, in nanoseconds per operation.
+static inline void bench_report(const char* name, const char* op, size_t size, double seconds, size_t op_count) {
+    printf("%-16s %-8s %12zu %10.2f ns/op\n", name, op, size, seconds * 1.0e9 / (double)op_count);
+    fflush(stdout);
+}
@@ -0,0 +1,155 @@
+#include "bench.h"
+
+#include <overture/concurrent_map.h>
+#include <overture/map.h>
+#include <overture/thread_pool.h>
+#include <overture/cli.h>
+#include <overture/mem.h>
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+static inline uint32_t hash_key(uint32_t h, const uint64_t* key) { return hash_uint64(h, *key); }
+static inline bool is_key_equal(const uint64_t* key, const uint64_t* other) { return *key == *other; }
+
+CONCURRENT_MAP_DEFINE(concurrent_map, uint64_t, uint64_t, hash_key, is_key_equal, PRIVATE)
+MAP_DEFINE(locked_map, uint64_t, uint64_t, hash_key, is_key_equal, PRIVATE)
+
+struct bench_work_item {
+    struct work_item item;
+    const uint64_t* keys;
+    size_t key_count;
+    struct concurrent_map* concurrent_map;
+    struct locked_map* locked_map;
+    pthread_mutex_t* mutex;
+    uint64_t sum;
+};
+
+static void insert_concurrent(struct work_item* item, size_t) {
+    struct bench_work_item* bench_item = (struct bench_work_item*)item;
+    for (size_t i = 0; i < bench_item->key_count; ++i)
+        concurrent_map_insert(bench_item->concurrent_map, &bench_item->keys[i], &bench_item->keys[i]);
+}
+
+static void find_concurrent(struct work_item* item, size_t) {
+    struct bench_work_item* bench_item = (struct bench_work_item*)item;
+    for (size_t i = 0; i < bench_item->key_count; ++i)
+        bench_item->sum += *concurrent_map_find(bench_item->concurrent_map, &bench_item->keys[i]);
+}
+
+static void insert_locked(struct work_item* item, size_t) {
+    struct bench_work_item* bench_item = (struct bench_work_item*)item;
+    for (size_t i = 0; i < bench_item->key_count; ++i) {
+        pthread_mutex_lock(bench_item->mutex);
+        locked_map_insert(bench_item->locked_map, &bench_item->keys[i], &bench_item->keys[i]);
+        pthread_mutex_unlock(bench_item->mutex);
+    }
+}
+
+static void find_locked(struct work_item* item, size_t) {
+    struct bench_work_item* bench_item = (struct bench_work_item*)item;
+    for (size_t i = 0; i < bench_item->key_count; ++i) {
+        pthread_mutex_lock(bench_item->mutex);
+        bench_item->sum += *locked_map_find(bench_item->locked_map, &bench_item->keys[i]);
+        pthread_mutex_unlock(bench_item->mutex);
+    }
+}
+
+// Splits the keys evenly among the threads, and runs the given function on each part.
+static double run(
+    struct thread_pool* thread_pool,
+    struct bench_work_item* items,
+    void (*work_func)(struct work_item*, size_t))
+{
+    size_t thread_count = thread_pool_size(thread_pool);
+    for (size_t i = 0; i < thread_count; ++i) {
+        items[i].item.work_func = work_func;
+        items[i].item.next = i + 1 < thread_count ? &items[i + 1].item : NULL;
+    }
+    double start = bench_time();
+    thread_pool_submit(thread_pool, &items[0].item, &items[thread_count - 1].item);
+    thread_pool_wait(thread_pool, 0);
+    return bench_time() - start;
+}
+
+static void bench(struct thread_pool* thread_pool, const uint64_t* keys, size_t key_count) {
+    size_t thread_count = thread_pool_size(thread_pool);
+    struct bench_work_item* items = xcalloc(thread_count, sizeof(struct bench_work_item));
+    struct concurrent_map concurrent_map = concurrent_map_create();
+    struct locked_map locked_map = locked_map_create();
+    pthread_mutex_t mutex;
+    pthread_mutex_init(&mutex, NULL);
+    for (size_t i = 0; i < thread_count; ++i) {
+        size_t first = i * key_count / thread_count;
+        size_t last = (i + 1) * key_count / thread_count;
+        items[i].keys = keys + first;
+        items[i].key_count = last - first;
+        items[i].concurrent_map = &concurrent_map;
+        items[i].locked_map = &locked_map;
+        items[i].mutex = &mutex;
+    }
+
+    char name[32];
+    snprintf(name, sizeof(name), "concurrent/%zu", thread_count);
+    bench_report(name, "insert", key_count, run(thread_pool, items, insert_concurrent), key_count);
+    bench_report(name, "find",   key_count, run(thread_pool, items, find_concurrent),   key_count);
+    snprintf(name, sizeof(name), "locked/%zu", thread_count);
+    bench_report(name, "insert", key_count, run(thread_pool, items, insert_locked), key_count);
+    bench_report(name, "find",   key_count, run(thread_pool, items, find_locked),   key_count);
+
+    uint64_t sum = 0;
+    for (size_t i = 0; i < thread_count; ++i)
+        sum += items[i].sum;
+    bench_use(sum);
+
+    pthread_mutex_destroy(&mutex);
+    locked_map_destroy(&locked_map);
+    concurrent_map_destroy(&concurrent_map);
+    free(items);
+}
+
+static enum cli_state usage(void*, char*) {
+    printf(
+        "usage: bench_concurrent_map [options]\n"
+        "options:\n"
+        "   -h    --help              Shows this message.\n"
+        "         --keys <n>          Number of keys to insert and find (default: 10000000).\n"
+        "         --max-threads <n>   Largest number of threads to use (default: number of cores).\n");
+    return CLI_STATE_ERROR;
+}
+
+int main(int argc, char** argv) {
+    uint64_t key_count = 10000000;
+    uint64_t max_threads = 0;
+    struct cli_option cli_options[] = {
+        { .short_name = "-h", .long_name = "--help", .parse = usage },
+        cli_option_uint64(NULL, "--keys", &key_count),
+        cli_option_uint64(NULL, "--max-threads", &max_threads),
+    };
+    if (!cli_parse_options(argc, argv, cli_options, sizeof(cli_options) / sizeof(cli_options[0])))
+        return 1;
+
+    if (max_threads == 0) {
+        struct thread_pool* thread_pool = thread_pool_create(0);
+        max_threads = thread_pool_size(thread_pool);
+        thread_pool_destroy(thread_pool);
+    }
+
+    uint64_t* keys = xmalloc(sizeof(uint64_t) * key_count);
+    for (size_t i = 0; i < key_count; ++i)
+        keys[i] = bench_key(i);
+
+    for (size_t thread_count = 1;; thread_count *= 2) {
+        if (thread_count > max_threads)
+            thread_count = max_threads;
+        struct thread_pool* thread_pool = thread_pool_create(thread_count);
+        bench(thread_pool, keys, key_count);
+        thread_pool_destroy(thread_pool);
+        if (thread_count == max_threads)
+            break;
+    }
+
+    free(keys);
+    return 0;
+}
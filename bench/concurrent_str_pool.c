@@ -0,0 +1,161 @@
+#include "bench.h"
+
+#include <overture/concurrent_str_pool.h>
+#include <overture/str_pool.h>
+#include <overture/mem_pool.h>
+#include <overture/thread_pool.h>
+#include <overture/cli.h>
+#include <overture/mem.h>
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+struct bench_work_item {
+    struct work_item item;
+    const struct str_view* words;
+    size_t word_count;
+    size_t first, last;
+    struct concurrent_str_pool* concurrent_str_pool;
+    struct mem_pool mem_pool;
+    struct str_pool* locked_str_pool;
+    pthread_mutex_t* mutex;
+    uint64_t sum;
+};
+
+// Tokens are drawn at random from the words, so that each thread sees most of them.
+static inline const struct str_view* token(const struct bench_work_item* bench_item, size_t i) {
+    return &bench_item->words[bench_key(i) % bench_item->word_count];
+}
+
+static void intern_concurrent(struct work_item* item, size_t) {
+    struct bench_work_item* bench_item = (struct bench_work_item*)item;
+    for (size_t i = bench_item->first; i < bench_item->last; ++i) {
+        const char* str = concurrent_str_pool_insert_view(bench_item->concurrent_str_pool, &bench_item->mem_pool, *token(bench_item, i));
+        bench_item->sum += (uintptr_t)str;
+    }
+}
+
+static void intern_locked(struct work_item* item, size_t) {
+    struct bench_work_item* bench_item = (struct bench_work_item*)item;
+    for (size_t i = bench_item->first; i < bench_item->last; ++i) {
+        pthread_mutex_lock(bench_item->mutex);
+        const char* str = str_pool_insert_view(bench_item->locked_str_pool, *token(bench_item, i));
+        pthread_mutex_unlock(bench_item->mutex);
+        bench_item->sum += (uintptr_t)str;
+    }
+}
+
+static double run(
+    struct thread_pool* thread_pool,
+    struct bench_work_item* items,
+    void (*work_func)(struct work_item*, size_t))
+{
+    size_t thread_count = thread_pool_size(thread_pool);
+    for (size_t i = 0; i < thread_count; ++i) {
+        items[i].item.work_func = work_func;
+        items[i].item.next = i + 1 < thread_count ? &items[i + 1].item : NULL;
+    }
+    double start = bench_time();
+    thread_pool_submit(thread_pool, &items[0].item, &items[thread_count - 1].item);
+    thread_pool_wait(thread_pool, 0);
+    return bench_time() - start;
+}
+
+static void bench(struct thread_pool* thread_pool, const struct str_view* words, size_t word_count, size_t token_count) {
+    size_t thread_count = thread_pool_size(thread_pool);
+    struct bench_work_item* items = xcalloc(thread_count, sizeof(struct bench_work_item));
+    struct concurrent_str_pool* concurrent_str_pool = concurrent_str_pool_create();
+    struct mem_pool locked_mem_pool = mem_pool_create();
+    struct str_pool* locked_str_pool = str_pool_create(&locked_mem_pool);
+    pthread_mutex_t mutex;
+    pthread_mutex_init(&mutex, NULL);
+    for (size_t i = 0; i < thread_count; ++i) {
+        items[i].words = words;
+        items[i].word_count = word_count;
+        items[i].first = i * token_count / thread_count;
+        items[i].last = (i + 1) * token_count / thread_count;
+        items[i].concurrent_str_pool = concurrent_str_pool;
+        items[i].mem_pool = mem_pool_create();
+        items[i].locked_str_pool = locked_str_pool;
+        items[i].mutex = &mutex;
+    }
+
+    char name[32];
+    snprintf(name, sizeof(name), "concurrent/%zu", thread_count);
+    bench_report(name, "intern", token_count, run(thread_pool, items, intern_concurrent), token_count);
+    snprintf(name, sizeof(name), "locked/%zu", thread_count);
+    bench_report(name, "intern", token_count, run(thread_pool, items, intern_locked), token_count);
+
+    uint64_t sum = 0;
+    for (size_t i = 0; i < thread_count; ++i) {
+        sum += items[i].sum;
+        mem_pool_destroy(&items[i].mem_pool);
+    }
+    bench_use(sum);
+
+    pthread_mutex_destroy(&mutex);
+    str_pool_destroy(locked_str_pool);
+    mem_pool_destroy(&locked_mem_pool);
+    concurrent_str_pool_destroy(concurrent_str_pool);
+    free(items);
+}
+
+static enum cli_state usage(void*, char*) {
+    printf(
+        "usage: bench_concurrent_str_pool [options]\n"
+        "options:\n"
+        "   -h    --help              Shows this message.\n"
+        "         --tokens <n>        Number of tokens to intern (default: 20000000).\n"
+        "         --words <n>         Number of distinct words among the tokens (default: 1000000).\n"
+        "         --max-threads <n>   Largest number of threads to use (default: number of cores).\n");
+    return CLI_STATE_ERROR;
+}
+
+int main(int argc, char** argv) {
+    uint64_t token_count = 20000000;
+    uint64_t word_count = 1000000;
+    uint64_t max_threads = 0;
+    struct cli_option cli_options[] = {
+        { .short_name = "-h", .long_name = "--help", .parse = usage },
+        cli_option_uint64(NULL, "--tokens", &token_count),
+        cli_option_uint64(NULL, "--words", &word_count),
+        cli_option_uint64(NULL, "--max-threads", &max_threads),
+    };
+    if (!cli_parse_options(argc, argv, cli_options, sizeof(cli_options) / sizeof(cli_options[0])))
+        return 1;
+    if (word_count == 0)
+        word_count = 1;
+
+    if (max_threads == 0) {
+        struct thread_pool* thread_pool = thread_pool_create(0);
+        max_threads = thread_pool_size(thread_pool);
+        thread_pool_destroy(thread_pool);
+    }
+
+    // Words look like identifiers of varying length, between 4 and 35 characters.
+    struct mem_pool word_mem_pool = mem_pool_create();
+    struct str_view* words = xmalloc(sizeof(struct str_view) * word_count);
+    for (size_t i = 0; i < word_count; ++i) {
+        uint64_t key = bench_key(i);
+        size_t length = 4 + key % 32;
+        char* data = mem_pool_alloc(&word_mem_pool, length, 1);
+        for (size_t j = 0; j < length; ++j, key = key * 31 + 7)
+            data[j] = 'a' + (char)((key >> 33) % 26);
+        words[i] = (struct str_view) { .data = data, .length = length };
+    }
+
+    for (size_t thread_count = 1;; thread_count *= 2) {
+        if (thread_count > max_threads)
+            thread_count = max_threads;
+        struct thread_pool* thread_pool = thread_pool_create(thread_count);
+        bench(thread_pool, words, word_count, token_count);
+        thread_pool_destroy(thread_pool);
+        if (thread_count == max_threads)
+            break;
+    }
+
+    free(words);
+    mem_pool_destroy(&word_mem_pool);
+    return 0;
+}
@@ -0,0 +1,120 @@
+#include "bench.h"
+
+#include <overture/hash.h>
+#include <overture/cli.h>
+#include <overture/mem.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define AVALANCHE_MAX_BITS 512
+
+static inline uint32_t hash_fnv_uint64(uint32_t h, uint64_t x) { return hash_uint64(h, x); }
+static inline uint32_t hash_fnv_bytes(uint32_t h, const void* data, size_t size) { return hash_bytes(h, data, size); }
+
+// Measures the time taken to hash `size` bytes at every offset of the given buffer, so that
+// measurements include unaligned inputs.
+#define BENCH_HASH(name) \
+    static void bench_##name##_bytes(const uint8_t* bytes, size_t size, size_t min_byte_count) { \
+        size_t rounds = (min_byte_count + size - 1) / size; \
+        uint32_t h = hash_init(); \
+        double start = bench_time(); \
+        for (size_t i = 0; i < rounds; ++i) \
+            h = hash_##name##_bytes(h, bytes + (i & 63), size); \
+        bench_report(#name, "bytes", size, bench_time() - start, rounds); \
+        bench_use(h); \
+    } \
+    static void bench_##name##_uint64(size_t op_count) { \
+        uint32_t h = hash_init(); \
+        double start = bench_time(); \
+        for (size_t i = 0; i < op_count; ++i) \
+            h ^= hash_##name##_uint64(hash_init(), i); \
+        bench_report(#name, "uint64", sizeof(uint64_t), bench_time() - start, op_count); \
+        bench_use(h); \
+    }
+
+BENCH_HASH(fnv)
+BENCH_HASH(fast)
+
+// Measures how well each input bit affects the output: Ideally, flipping one bit of the input flips
+// each bit of the output with a probability of 1/2. Reports the average and worst deviation from
+// that ideal probability, over all pairs of input and output bits.
+#define BENCH_AVALANCHE(name) \
+    static void bench_##name##_avalanche(size_t size, size_t sample_count) { \
+        static uint32_t flip_counts[AVALANCHE_MAX_BITS][32]; \
+        memset(flip_counts, 0, sizeof(flip_counts)); \
+        uint8_t bytes[AVALANCHE_MAX_BITS / 8]; \
+        for (size_t i = 0; i < sample_count; ++i) { \
+            for (size_t j = 0; j < size; ++j) \
+                bytes[j] = (uint8_t)bench_key(i * size + j); \
+            uint32_t h = hash_##name##_bytes(hash_init(), bytes, size); \
+            for (size_t bit = 0; bit < size * 8; ++bit) { \
+                bytes[bit / 8] ^= 1u << (bit % 8); \
+                uint32_t diff = h ^ hash_##name##_bytes(hash_init(), bytes, size); \
+                bytes[bit / 8] ^= 1u << (bit % 8); \
+                for (size_t k = 0; k < 32; ++k) \
+                    flip_counts[bit][k] += (diff >> k) & 1; \
+            } \
+        } \
+        double sum_bias = 0, max_bias = 0; \
+        for (size_t bit = 0; bit < size * 8; ++bit) { \
+            for (size_t k = 0; k < 32; ++k) { \
+                double bias = (double)flip_counts[bit][k] / (double)sample_count - 0.5; \
+                bias = bias < 0 ? -bias : bias; \
+                sum_bias += bias; \
+                max_bias = bias > max_bias ? bias : max_bias; \
+            } \
+        } \
+        printf("%-16s %-8s %12zu %10.4f avg %8.4f max\n", #name, "bias", size, \
+            sum_bias / (double)(size * 8 * 32), max_bias); \
+        fflush(stdout); \
+    }
+
+BENCH_AVALANCHE(fnv)
+BENCH_AVALANCHE(fast)
+
+static enum cli_state usage(void*, char*) {
+    printf(
+        "usage: bench_hash [options]\n"
+        "options:\n"
+        "   -h    --help            Shows this message.\n"
+        "         --max-size <n>    Largest input size to benchmark, in bytes (default: 65536).\n"
+        "         --samples <n>     Number of samples for the avalanche test (default: 10000).\n");
+    return CLI_STATE_ERROR;
+}
+
+int main(int argc, char** argv) {
+    uint64_t max_size = 65536;
+    uint64_t sample_count = 10000;
+    struct cli_option cli_options[] = {
+        { .short_name = "-h", .long_name = "--help", .parse = usage },
+        cli_option_uint64(NULL, "--max-size", &max_size),
+        cli_option_uint64(NULL, "--samples", &sample_count),
+    };
+    if (!cli_parse_options(argc, argv, cli_options, sizeof(cli_options) / sizeof(cli_options[0])))
+        return 1;
+    if (max_size == 0)
+        max_size = 1;
+    if (sample_count == 0)
+        sample_count = 1;
+
+    uint8_t* bytes = xmalloc(max_size + 64);
+    for (size_t i = 0; i < max_size + 64; ++i)
+        bytes[i] = (uint8_t)bench_key(i);
+
+    const size_t min_byte_count = 100000000;
+    bench_fnv_uint64(min_byte_count / sizeof(uint64_t));
+    bench_fast_uint64(min_byte_count / sizeof(uint64_t));
+    for (size_t size = 4; size <= max_size; size *= 4) {
+        bench_fnv_bytes(bytes, size, min_byte_count);
+        bench_fast_bytes(bytes, size, min_byte_count);
+    }
+    for (size_t size = 4; size <= AVALANCHE_MAX_BITS / 8; size *= 4) {
+        bench_fnv_avalanche(size, sample_count);
+        bench_fast_avalanche(size, sample_count);
+    }
+
+    free(bytes);
+    return 0;
+}
@@ -0,0 +1,108 @@
+#include "bench.h"
+
+#include <overture/map.h>
+#include <overture/cli.h>
+#include <overture/mem.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+
+static inline uint32_t hash_key(uint32_t h, const uint64_t* key) { return hash_uint64(h, *key); }
+static inline bool is_key_equal(const uint64_t* key, const uint64_t* other) { return *key == *other; }
+
+MAP_DEFINE(prime_map, uint64_t, uint64_t, hash_key, is_key_equal, PRIVATE)
+MAP_DEFINE_WITH_FLAGS(pow2_map, uint64_t, uint64_t, hash_key, is_key_equal, HASH_TABLE_POW2, PRIVATE)
+MAP_DEFINE_TRIVIAL(trivial_map, uint64_t, uint64_t, hash_key, PRIVATE)
+
+#define BENCH_BATCH_SIZE 256
+
+// Measures insertion, lookup, and removal of `key_count` keys, as well as batched insertion and
+// lookup (marked with `*`). Small sizes are repeated so that each measurement covers roughly the
+// same total number of operations.
+#define BENCH_MAP(name) \
+    static void bench_##name(const uint64_t* keys, size_t key_count, size_t min_op_count) { \
+        size_t rounds = key_count < min_op_count ? min_op_count / key_count : 1; \
+        double insert_time = 0, find_time = 0, remove_time = 0; \
+        double insert_many_time = 0, find_many_time = 0; \
+        const uint64_t* found_vals[BENCH_BATCH_SIZE]; \
+        uint64_t sum = 0; \
+        for (size_t round = 0; round < rounds; ++round) { \
+            struct name map = name##_create(); \
+            double start = bench_time(); \
+            for (size_t i = 0; i < key_count; ++i) \
+                name##_insert(&map, &keys[i], &keys[i]); \
+            double end = bench_time(); \
+            insert_time += end - start; \
+            start = end; \
+            for (size_t i = 0; i < key_count; ++i) \
+                sum += *name##_find(&map, &keys[i]); \
+            end = bench_time(); \
+            find_time += end - start; \
+            start = end; \
+            for (size_t i = 0; i < key_count; ++i) \
+                name##_remove(&map, &keys[i]); \
+            remove_time += bench_time() - start; \
+            name##_destroy(&map); \
+            map = name##_create(); \
+            start = bench_time(); \
+            name##_insert_many(&map, keys, keys, key_count); \
+            end = bench_time(); \
+            insert_many_time += end - start; \
+            start = end; \
+            for (size_t i = 0; i < key_count; i += BENCH_BATCH_SIZE) { \
+                size_t batch_size = key_count - i < BENCH_BATCH_SIZE ? key_count - i : BENCH_BATCH_SIZE; \
+                name##_find_many(&map, &keys[i], found_vals, batch_size); \
+                for (size_t j = 0; j < batch_size; ++j) \
+                    sum += *found_vals[j]; \
+            } \
+            find_many_time += bench_time() - start; \
+            name##_destroy(&map); \
+        } \
+        bench_use(sum); \
+        bench_report(#name, "insert", key_count, insert_time, rounds * key_count); \
+        bench_report(#name, "find",   key_count, find_time,   rounds * key_count); \
+        bench_report(#name, "remove", key_count, remove_time, rounds * key_count); \
+        bench_report(#name, "insert*", key_count, insert_many_time, rounds * key_count); \
+        bench_report(#name, "find*",   key_count, find_many_time,   rounds * key_count); \
+    }
+
+BENCH_MAP(prime_map)
+BENCH_MAP(pow2_map)
+BENCH_MAP(trivial_map)
+
+static enum cli_state usage(void*, char*) {
+    printf(
+        "usage: bench_hash_table [options]\n"
+        "options:\n"
+        "   -h    --help           Shows this message.\n"
+        "         --min-keys <n>   Smallest number of keys to benchmark (default: 1000).\n"
+        "         --max-keys <n>   Largest number of keys to benchmark (default: 100000000).\n");
+    return CLI_STATE_ERROR;
+}
+
+int main(int argc, char** argv) {
+    uint64_t min_keys = 1000;
+    uint64_t max_keys = 100000000;
+    struct cli_option cli_options[] = {
+        { .short_name = "-h", .long_name = "--help", .parse = usage },
+        cli_option_uint64(NULL, "--min-keys", &min_keys),
+        cli_option_uint64(NULL, "--max-keys", &max_keys),
+    };
+    if (!cli_parse_options(argc, argv, cli_options, sizeof(cli_options) / sizeof(cli_options[0])))
+        return 1;
+    if (min_keys == 0)
+        min_keys = 1;
+
+    uint64_t* keys = xmalloc(sizeof(uint64_t) * max_keys);
+    for (size_t i = 0; i < max_keys; ++i)
+        keys[i] = bench_key(i);
+
+    for (size_t key_count = min_keys; key_count <= max_keys; key_count *= 10) {
+        bench_prime_map(keys, key_count, max_keys < 10000000 ? max_keys : 10000000);
+        bench_pow2_map(keys, key_count, max_keys < 10000000 ? max_keys : 10000000);
+        bench_trivial_map(keys, key_count, max_keys < 10000000 ? max_keys : 10000000);
+    }
+
+    free(keys);
+    return 0;
+}
@@ -0,0 +1,90 @@
+#include "bench.h"
+
+#include <overture/log.h>
+#include <overture/line_reader.h>
+#include <overture/cli.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#define SOURCE_FILE_NAME "bench_log_source.txt"
+#define SOURCE_LINE_COUNT 10000
+
+static enum cli_state usage(void*, char*) {
+    printf(
+        "usage: bench_log [options]\n"
+        "options:\n"
+        "   -h    --help            Shows this message.\n"
+        "         --count <n>       Number of diagnostics to emit (default: 100000).\n");
+    return CLI_STATE_ERROR;
+}
+
+// Emits diagnostics at random locations of a source file, each followed by a note, and reports
+// the time taken per diagnostic.
+static void bench_log(const char* name, struct log* log, size_t diag_count) {
+    double start = bench_time();
+    for (size_t i = 0; i < diag_count; ++i) {
+        uint64_t key = bench_key(i);
+        uint32_t row = 1 + key % SOURCE_LINE_COUNT;
+        uint32_t col = 1 + (key >> 32) % 40;
+        struct file_loc loc = {
+            .file_name = SOURCE_FILE_NAME,
+            .displayed_file_name = SOURCE_FILE_NAME,
+            .displayed_line = row,
+            .begin = { .row = row, .col = col },
+            .end = { .row = row, .col = col + 8 }
+        };
+        log_msg(i % 3 == 0 ? MSG_ERROR : MSG_WARN, log, &loc, "unused variable 'x%zu'", i);
+        log_note(log, NULL, "declared here");
+    }
+    bench_report(name, "diag", diag_count, bench_time() - start, diag_count);
+}
+
+int main(int argc, char** argv) {
+    uint64_t diag_count = 100000;
+    struct cli_option cli_options[] = {
+        { .short_name = "-h", .long_name = "--help", .parse = usage },
+        cli_option_uint64(NULL, "--count", &diag_count),
+    };
+    if (!cli_parse_options(argc, argv, cli_options, sizeof(cli_options) / sizeof(cli_options[0])))
+        return 1;
+
+    FILE* source_file = fopen(SOURCE_FILE_NAME, "wb");
+    if (!source_file)
+        return 1;
+    for (size_t i = 0; i < SOURCE_LINE_COUNT; ++i)
+        fprintf(source_file, "    int x%zu = %zu; // line %zu of the source file\n", i, i * 7, i + 1);
+    fclose(source_file);
+
+    struct line_reader* line_reader = file_line_reader_create();
+    // Writing to the null device measures the cost of formatting and writing messages, without the
+    // cost of storing them.
+    FILE* file = fopen("/dev/null", "wb");
+    if (!file)
+        file = tmpfile();
+    struct log log = {
+        .file = file,
+        .max_errors = SIZE_MAX,
+        .max_warns = SIZE_MAX,
+        .line_reader = line_reader
+    };
+    bench_log("immediate", &log, diag_count);
+
+    log.defer_msgs = true;
+    log.error_count = log.warn_count = 0;
+    double start = bench_time();
+    bench_log("deferred", &log, diag_count);
+    log_flush(&log);
+    bench_report("deferred+flush", "diag", diag_count, bench_time() - start, diag_count);
+
+    log.defer_msgs = false;
+    log.format = LOG_FORMAT_JSON;
+    bench_log("json", &log, diag_count);
+    log_flush(&log);
+    log_destroy(&log);
+
+    fclose(file);
+    file_line_reader_destroy(line_reader);
+    remove(SOURCE_FILE_NAME);
+    return 0;
+}
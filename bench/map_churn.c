@@ -0,0 +1,162 @@
+#include "bench.h"
+
+#include <overture/map.h>
+#include <overture/minstd.h>
+#include <overture/cli.h>
+#include <overture/mem.h>
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+static inline uint32_t hash_key(uint32_t h, const uint64_t* key) { return hash_uint64(h, *key); }
+static inline bool is_key_equal(const uint64_t* key, const uint64_t* other) { return *key == *other; }
+
+MAP_DEFINE(linear_map, uint64_t, uint64_t, hash_key, is_key_equal, PRIVATE)
+MAP_DEFINE_WITH_FLAGS(pow2_map, uint64_t, uint64_t, hash_key, is_key_equal, HASH_TABLE_POW2, PRIVATE)
+MAP_DEFINE_WITH_FLAGS(grouped_map, uint64_t, uint64_t, hash_key, is_key_equal, HASH_TABLE_GROUPED | HASH_TABLE_POW2, PRIVATE)
+MAP_DEFINE_WITH_FLAGS(incremental_map, uint64_t, uint64_t, hash_key, is_key_equal, HASH_TABLE_POW2 | HASH_TABLE_INCREMENTAL, PRIVATE)
+
+struct options {
+    uint64_t key_count;
+    uint64_t op_count;
+    uint32_t seed;
+    bool check;
+};
+
+// Runs a random mix of insertions, removals, and lookups, over keys drawn from a fixed set, such
+// that the map stays roughly half full. When checking is enabled, every result is compared against
+// a reference model (an array of flags indicating which keys are present), and the program aborts
+// on the first mismatch.
+#define BENCH_CHURN(name) \
+    static bool bench_##name(const uint64_t* keys, const struct options* options) { \
+        struct name map = name##_create(); \
+        bool* is_present = options->check ? xcalloc(options->key_count, sizeof(bool)) : NULL; \
+        uint64_t* ref_vals = options->check ? xcalloc(options->key_count, sizeof(uint64_t)) : NULL; \
+        size_t ref_count = 0; \
+        bool ok = true; \
+        uint64_t sum = 0; \
+        uint32_t state = options->seed ? options->seed : 1; \
+        for (size_t i = 0; i < options->key_count; i += 2) { \
+            uint64_t val = i; \
+            name##_insert(&map, &keys[i], &val); \
+            if (options->check) { \
+                is_present[i] = true; \
+                ref_vals[i] = val; \
+                ref_count++; \
+            } \
+        } \
+        double start = bench_time(); \
+        for (size_t op = 0; op < options->op_count && ok; ++op) { \
+            uint32_t rand = minstd_gen(&state); \
+            size_t idx = (rand >> 2) % options->key_count; \
+            const uint64_t* key = &keys[idx]; \
+            switch (rand & 3) { \
+                case 0: { \
+                    uint64_t val = op; \
+                    bool inserted = name##_insert(&map, key, &val); \
+                    if (options->check) { \
+                        ok &= inserted == !is_present[idx]; \
+                        if (inserted) { \
+                            is_present[idx] = true; \
+                            ref_vals[idx] = val; \
+                            ref_count++; \
+                        } \
+                    } \
+                    break; \
+                } \
+                case 1: { \
+                    bool removed = name##_remove(&map, key); \
+                    if (options->check) { \
+                        ok &= removed == is_present[idx]; \
+                        ref_count -= removed ? 1 : 0; \
+                        is_present[idx] = false; \
+                    } \
+                    break; \
+                } \
+                default: { \
+                    const uint64_t* val = name##_find(&map, key); \
+                    sum += val ? *val : 0; \
+                    if (options->check) \
+                        ok &= is_present[idx] ? val && *val == ref_vals[idx] : !val; \
+                    break; \
+                } \
+            } \
+            if (options->check) \
+                ok &= map.elem_count == ref_count; \
+        } \
+        double time = bench_time() - start; \
+        bench_use(sum); \
+        if (options->check) { \
+            for (size_t i = 0; i < options->key_count; ++i) { \
+                const uint64_t* val = name##_find(&map, &keys[i]); \
+                ok &= is_present[i] ? val && *val == ref_vals[i] : !val; \
+            } \
+            size_t count = 0; \
+            MAP_FOREACH_KEY(uint64_t, key, map) { \
+                ok &= name##_find(&map, key) != NULL; \
+                count++; \
+            } \
+            ok &= count == ref_count; \
+        } \
+        struct hash_table_stats stats = hash_table_stats(&map.hash_table); \
+        bench_report(#name, "churn", options->key_count, time, options->op_count); \
+        printf("%-16s %-8s %12zu %10.2f mean, %zu max, %.2f load, %zu tombstones\n", \
+            #name, "probes", options->key_count, stats.mean_probe_length, stats.max_probe_length, \
+            stats.load_factor, stats.tombstone_count); \
+        if (!ok) \
+            fprintf(stderr, "%s: mismatch with the reference model (seed: %"PRIu32")\n", #name, options->seed); \
+        free(is_present); \
+        free(ref_vals); \
+        name##_destroy(&map); \
+        return ok; \
+    }
+
+BENCH_CHURN(linear_map)
+BENCH_CHURN(pow2_map)
+BENCH_CHURN(grouped_map)
+BENCH_CHURN(incremental_map)
+
+static enum cli_state usage(void*, char*) {
+    printf(
+        "usage: bench_map_churn [options]\n"
+        "options:\n"
+        "   -h    --help         Shows this message.\n"
+        "         --keys <n>     Number of distinct keys (default: 1000000).\n"
+        "         --ops <n>      Number of operations (default: 10000000).\n"
+        "         --seed <n>     Seed of the random number generator (default: 1).\n"
+        "         --check        Checks every operation against a reference model.\n");
+    return CLI_STATE_ERROR;
+}
+
+int main(int argc, char** argv) {
+    struct options options = {
+        .key_count = 1000000,
+        .op_count = 10000000,
+        .seed = 1
+    };
+    struct cli_option cli_options[] = {
+        { .short_name = "-h", .long_name = "--help", .parse = usage },
+        cli_option_uint64(NULL, "--keys", &options.key_count),
+        cli_option_uint64(NULL, "--ops", &options.op_count),
+        cli_option_uint32(NULL, "--seed", &options.seed),
+        cli_flag(NULL, "--check", &options.check),
+    };
+    if (!cli_parse_options(argc, argv, cli_options, sizeof(cli_options) / sizeof(cli_options[0])))
+        return 1;
+    if (options.key_count == 0)
+        options.key_count = 1;
+
+    uint64_t* keys = xmalloc(sizeof(uint64_t) * options.key_count);
+    for (size_t i = 0; i < options.key_count; ++i)
+        keys[i] = bench_key(i);
+
+    bool ok = true;
+    ok &= bench_linear_map(keys, &options);
+    ok &= bench_pow2_map(keys, &options);
+    ok &= bench_grouped_map(keys, &options);
+    ok &= bench_incremental_map(keys, &options);
+
+    free(keys);
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,131 @@
+#include "bench.h"
+
+#include <overture/str.h>
+#include <overture/small_str.h>
+#include <overture/str_rope.h>
+#include <overture/mem_pool.h>
+#include <overture/cli.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+
+// Number of strings built between two resets of the memory pool.
+#define POOL_RESET_PERIOD 1024
+
+// Builds a temporary string of (at least) the given size, the way a diagnostic message would be
+// formatted: A formatted location prefix, followed by fixed fragments.
+static inline uint64_t build_str(struct str* str, size_t size, size_t i) {
+    str_printf(str, "file.c:%zu:%zu: ", i, i & 127);
+    while (str->length < size)
+        str_append(str, STR_VIEW("lorem ipsum "));
+    return (uint64_t)(unsigned char)str_terminate(str)[size / 2];
+}
+
+static inline uint64_t build_small_str(struct small_str* small_str, size_t size, size_t i) {
+    small_str_printf(small_str, "file.c:%zu:%zu: ", i, i & 127);
+    while (small_str->str.length < size)
+        small_str_append(small_str, STR_VIEW("lorem ipsum "));
+    return (uint64_t)(unsigned char)small_str_terminate(small_str)[size / 2];
+}
+
+static void bench_heap(size_t size, size_t op_count) {
+    uint64_t sum = 0;
+    double start = bench_time();
+    for (size_t i = 0; i < op_count; ++i) {
+        struct str str = str_create();
+        sum += build_str(&str, size, i);
+        str_destroy(&str);
+    }
+    bench_report("heap", "build", size, bench_time() - start, op_count);
+    bench_use(sum);
+}
+
+static void bench_small(size_t size, size_t op_count, struct mem_pool* mem_pool) {
+    uint64_t sum = 0;
+    double start = bench_time();
+    for (size_t i = 0; i < op_count; ++i) {
+        if (mem_pool && i % POOL_RESET_PERIOD == 0)
+            mem_pool_reset(mem_pool);
+        struct small_str small_str;
+        small_str_init(&small_str, mem_pool);
+        sum += build_small_str(&small_str, size, i);
+        small_str_destroy(&small_str);
+    }
+    bench_report(mem_pool ? "small+pool" : "small", "build", size, bench_time() - start, op_count);
+    bench_use(sum);
+}
+
+// Assembles a large output from many borrowed fragments, either by appending them to a string, or
+// by recording them in a rope and flattening it at the end.
+static void bench_concat(const struct str_view* fragments, size_t fragment_count) {
+    size_t total_length = 0;
+    double start = bench_time();
+    struct str str = str_create();
+    for (size_t i = 0; i < fragment_count; ++i)
+        str_append(&str, fragments[i]);
+    total_length += str.length;
+    str_destroy(&str);
+    bench_report("append", "concat", fragment_count, bench_time() - start, fragment_count);
+
+    start = bench_time();
+    struct str_rope* rope = str_rope_create();
+    for (size_t i = 0; i < fragment_count; ++i)
+        str_rope_append_view(rope, fragments[i]);
+    str = str_create();
+    str_rope_flatten(rope, &str);
+    total_length += str.length;
+    str_destroy(&str);
+    str_rope_destroy(rope);
+    bench_report("rope", "concat", fragment_count, bench_time() - start, fragment_count);
+    bench_use(total_length);
+}
+
+static enum cli_state usage(void*, char*) {
+    printf(
+        "usage: bench_str [options]\n"
+        "options:\n"
+        "   -h    --help            Shows this message.\n"
+        "         --max-size <n>    Largest string to build, in bytes (default: 1024).\n"
+        "         --ops <n>         Number of strings to build per measurement (default: 1000000).\n"
+        "         --fragments <n>   Number of fragments to concatenate (default: 1000000).\n");
+    return CLI_STATE_ERROR;
+}
+
+int main(int argc, char** argv) {
+    uint64_t max_size = 1024;
+    uint64_t op_count = 1000000;
+    uint64_t fragment_count = 1000000;
+    struct cli_option cli_options[] = {
+        { .short_name = "-h", .long_name = "--help", .parse = usage },
+        cli_option_uint64(NULL, "--max-size", &max_size),
+        cli_option_uint64(NULL, "--ops", &op_count),
+        cli_option_uint64(NULL, "--fragments", &fragment_count),
+    };
+    if (!cli_parse_options(argc, argv, cli_options, sizeof(cli_options) / sizeof(cli_options[0])))
+        return 1;
+    if (op_count == 0)
+        op_count = 1;
+
+    struct mem_pool mem_pool = mem_pool_create();
+    for (size_t size = 16; size <= max_size; size *= 4) {
+        bench_heap(size, op_count);
+        bench_small(size, op_count, NULL);
+        bench_small(size, op_count, &mem_pool);
+    }
+    mem_pool_destroy(&mem_pool);
+
+    // Fragments of 1 to 64 bytes, from a buffer that is larger than the caches.
+    size_t buf_size = 1 << 24;
+    char* buf = xmalloc(buf_size + 64);
+    for (size_t i = 0; i < buf_size + 64; ++i)
+        buf[i] = (char)('a' + bench_key(i) % 26);
+    struct str_view* fragments = xmalloc(sizeof(struct str_view) * fragment_count);
+    for (size_t i = 0; i < fragment_count; ++i) {
+        uint64_t key = bench_key(i);
+        fragments[i] = (struct str_view) { .data = buf + (key >> 8) % buf_size, .length = 1 + key % 64 };
+    }
+    bench_concat(fragments, fragment_count);
+    free(fragments);
+    free(buf);
+    return 0;
+}
@@ -0,0 +1,126 @@
+#include "bench.h"
+
+#include <overture/str.h>
+#include <overture/cli.h>
+#include <overture/mem.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Scans the input one character at a time, which is the baseline for the other functions.
+static size_t scalar_count_char(struct str_view str_view, char c) {
+    size_t count = 0;
+    for (size_t i = 0; i < str_view.length; ++i)
+        count += str_view.data[i] == c;
+    return count;
+}
+
+static size_t memchr_count_char(struct str_view str_view, char c) {
+    size_t count = 0;
+    const char* end = str_view.data + str_view.length;
+    for (const char* p = str_view.data; (p = memchr(p, c, end - p)); ++p)
+        count++;
+    return count;
+}
+
+static size_t scalar_count_lines(struct str_view str_view) {
+    size_t count = 0;
+    size_t line_begin = 0;
+    for (size_t i = 0; i < str_view.length; ++i) {
+        if (str_view.data[i] == '\n') {
+            count += i > line_begin;
+            line_begin = i + 1;
+        }
+    }
+    return count + (str_view.length > line_begin);
+}
+
+static size_t count_char(struct str_view str_view, char c) {
+    size_t count = 0;
+    for (size_t i; (i = str_view_find_char(str_view, c)) != STR_VIEW_NOT_FOUND; count++)
+        str_view = str_view_shrink(str_view, i + 1, 0);
+    return count;
+}
+
+static size_t count_lines(struct str_view str_view) {
+    size_t count = 0;
+    struct str_view_lines lines = str_view_lines(str_view);
+    struct str_view line;
+    while (str_view_lines_next(&lines, &line))
+        count += line.length > 0;
+    return count;
+}
+
+static size_t count_needle(struct str_view str_view, struct str_view needle) {
+    size_t count = 0;
+    for (size_t i; (i = str_view_find(str_view, needle)) != STR_VIEW_NOT_FOUND; count++)
+        str_view = str_view_shrink(str_view, i + needle.length, 0);
+    return count;
+}
+
+static void report(const char* name, const char* op, size_t byte_count, double seconds) {
+    printf("%-16s %-8s %12zu %10.2f GB/s\n", name, op, byte_count, (double)byte_count / seconds * 1.0e-9);
+    fflush(stdout);
+}
+
+#define BENCH_SCAN(name, op, expr) \
+    do { \
+        size_t result = 0; \
+        double start = bench_time(); \
+        for (size_t pass = 0; pass < pass_count; ++pass) \
+            result += (expr); \
+        report(name, op, str_view.length * pass_count, bench_time() - start); \
+        bench_use(result); \
+    } while (false)
+
+static enum cli_state usage(void*, char*) {
+    printf(
+        "usage: bench_str_view [options]\n"
+        "options:\n"
+        "   -h    --help            Shows this message.\n"
+        "         --size <n>        Size of the input text, in bytes (default: 268435456).\n"
+        "         --passes <n>      Number of passes over the input text (default: 8).\n");
+    return CLI_STATE_ERROR;
+}
+
+int main(int argc, char** argv) {
+    uint64_t size = 1 << 28;
+    uint64_t pass_count = 8;
+    struct cli_option cli_options[] = {
+        { .short_name = "-h", .long_name = "--help", .parse = usage },
+        cli_option_uint64(NULL, "--size", &size),
+        cli_option_uint64(NULL, "--passes", &pass_count),
+    };
+    if (!cli_parse_options(argc, argv, cli_options, sizeof(cli_options) / sizeof(cli_options[0])))
+        return 1;
+    if (pass_count == 0)
+        pass_count = 1;
+
+    // Text made of lowercase words, with lines of 0 to 127 characters. The text never contains the
+    // character '#', so that searching for it measures the raw scanning throughput.
+    char* text = xmalloc(size);
+    for (size_t i = 0; i < size;) {
+        uint64_t key = bench_key(i);
+        size_t line_length = key % 128;
+        for (size_t j = 0; j < line_length && i < size; ++j, ++i)
+            text[i] = bench_key(i) % 6 == 0 ? ' ' : (char)('a' + bench_key(i) % 26);
+        if (i < size)
+            text[i++] = '\n';
+    }
+    struct str_view str_view = { .data = text, .length = size };
+    struct str_view needle = STR_VIEW("needle");
+
+    BENCH_SCAN("scalar", "char", scalar_count_char(str_view, '\n'));
+    BENCH_SCAN("memchr", "char", memchr_count_char(str_view, '\n'));
+    BENCH_SCAN("str_view", "char", count_char(str_view, '\n'));
+    BENCH_SCAN("scalar", "rare", scalar_count_char(str_view, '#'));
+    BENCH_SCAN("memchr", "rare", memchr_count_char(str_view, '#'));
+    BENCH_SCAN("str_view", "rare", count_char(str_view, '#'));
+    BENCH_SCAN("scalar", "lines", scalar_count_lines(str_view));
+    BENCH_SCAN("str_view", "lines", count_lines(str_view));
+    BENCH_SCAN("str_view", "find", count_needle(str_view, needle));
+
+    free(text);
+    return 0;
+}
@@ -57,3 +57,15 @@ static_assert(sizeof(uint32_t) == sizeof(float));
     xmemcpy(&y, &x, sizeof(x));
     return y;
 }
+
+/// @return The number of trailing zero bits in the given value, which must not be zero.
+[[nodiscard]] static inline size_t count_trailing_zeros(uint32_t x) {
+    assert(x != 0);
+    return __builtin_ctz(x);
+}
+
+/// @return The number of leading zero bits in the given value, which must not be zero.
+[[nodiscard]] static inline size_t count_leading_zeros(uint32_t x) {
+    assert(x != 0);
+    return __builtin_clz(x);
+}
@@ -0,0 +1,395 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <stdatomic.h>
+#include <assert.h>
+
+#if defined (__unix__) || (defined (__APPLE__) && defined (__MACH__))
+#include <sched.h>
+#endif
+
+#include "hash_table.h"
+#include "mem.h"
+
+/// @file
+///
+/// Low-level concurrent hash table data structure, which supports lookups and insertions from
+/// several threads at the same time. When possible, prefer the use of the concurrent map or set
+/// data structures, as they provide more type safety.
+///
+/// Just like @ref hash_table, the hashes of the keys are stored with one bit reserved for an
+/// occupancy flag. Two other bits are reserved: One marks buckets that are being written by an
+/// insertion, and the other marks buckets that have been frozen because the table is being
+/// resized. Lookups are wait-free: They never write to the table, and never wait for other threads.
+/// Insertions claim an empty bucket with an atomic compare-and-swap, write the key and value, and
+/// then publish the bucket by setting its occupancy flag. Insertions are not lock-free: One that
+/// reaches a bucket claimed for an element with the same hash waits until that bucket is published,
+/// since that element may be equal to the one being inserted. When the table becomes too full, a
+/// single thread allocates a larger table, and all inserting threads then cooperate to migrate the
+/// elements into it, by claiming chunks of buckets. Tables replaced by a larger one are only freed when the hash table is destroyed, since
+/// other threads may still be reading them. Removing elements is not supported.
+
+/// Block of buckets for a concurrent hash table.
+struct concurrent_hash_table_block {
+    size_t capacity;                                    ///< Capacity, in number of elements.
+    unsigned bucket_shift;                              ///< Shift used to compute buckets.
+    _Atomic(uint32_t)* hashes;                          ///< Hashes of the keys, with three flag bits.
+    char* keys;                                         ///< Keys of the elements.
+    char* vals;                                         ///< Values of the elements. May be `NULL`.
+    atomic_size_t elem_count;                           ///< Number of elements inserted in this block.
+    atomic_size_t claimed_count;                        ///< Number of buckets claimed for migration.
+    atomic_size_t migrated_count;                       ///< Number of buckets migrated.
+    _Atomic(struct concurrent_hash_table_block*) next;  ///< Block that replaces this one, or `NULL`.
+};
+
+/// Concurrent hash table. Can represent both a map or a set.
+struct concurrent_hash_table {
+    _Atomic(struct concurrent_hash_table_block*) block; ///< Current block of buckets.
+    struct concurrent_hash_table_block* first_block;    ///< First block ever allocated, for destruction.
+};
+
+/// @cond PRIVATE
+#define CONCURRENT_HASH_TABLE_BUSY_FLAG UINT32_C(0x40000000)
+#define CONCURRENT_HASH_TABLE_MOVED_FLAG UINT32_C(0x20000000)
+#define CONCURRENT_HASH_TABLE_HASH_MASK UINT32_C(0x1FFFFFFF)
+#define CONCURRENT_HASH_TABLE_MIGRATION_CHUNK 1024
+
+// Marker stored as the next block of a block while the thread that resizes it allocates the next
+// block. Blocks are aligned, so this can never be the address of an actual block.
+#define CONCURRENT_HASH_TABLE_RESIZING ((struct concurrent_hash_table_block*)(uintptr_t)1)
+
+enum concurrent_hash_table_result {
+    CONCURRENT_HASH_TABLE_INSERTED,
+    CONCURRENT_HASH_TABLE_FOUND,
+    CONCURRENT_HASH_TABLE_FROZEN
+};
+
+static inline void concurrent_hash_table_yield(void) {
+#if defined (__unix__) || (defined (__APPLE__) && defined (__MACH__))
+    sched_yield();
+#endif
+}
+
+static inline struct concurrent_hash_table_block* concurrent_hash_table_alloc_block(
+    size_t key_size,
+    size_t val_size,
+    size_t capacity)
+{
+    capacity = hash_table_round_capacity(capacity, HASH_TABLE_POW2);
+    struct concurrent_hash_table_block* block = xmalloc(sizeof(struct concurrent_hash_table_block));
+    block->capacity = capacity;
+    block->bucket_shift = hash_table_compute_bucket_shift(capacity);
+    block->hashes = xcalloc(capacity, sizeof(_Atomic(uint32_t)));
+    block->keys = xmalloc(key_size * capacity);
+    block->vals = val_size > 0 ? xmalloc(val_size * capacity) : NULL;
+    atomic_init(&block->elem_count, 0);
+    atomic_init(&block->claimed_count, 0);
+    atomic_init(&block->migrated_count, 0);
+    atomic_init(&block->next, NULL);
+    return block;
+}
+
+static inline size_t concurrent_hash_table_first_bucket(const struct concurrent_hash_table_block* block, uint32_t hash) {
+    return (size_t)((hash * HASH_TABLE_FIBONACCI_FACTOR) >> block->bucket_shift);
+}
+
+static inline size_t concurrent_hash_table_next_bucket(const struct concurrent_hash_table_block* block, size_t bucket_idx) {
+    return (bucket_idx + 1) & (block->capacity - 1);
+}
+
+// Places an element in a block that is not visible to inserting threads yet. Since keys are
+// unique, this does not need to compare keys.
+static inline void concurrent_hash_table_place(
+    struct concurrent_hash_table_block* block,
+    const void* key,
+    const void* val,
+    size_t key_size,
+    size_t val_size,
+    uint32_t hash)
+{
+    uint32_t busy_hash = (hash & CONCURRENT_HASH_TABLE_HASH_MASK) | CONCURRENT_HASH_TABLE_BUSY_FLAG;
+    for (size_t idx = concurrent_hash_table_first_bucket(block, hash);; idx = concurrent_hash_table_next_bucket(block, idx)) {
+        uint32_t expected = 0;
+        if (atomic_compare_exchange_strong_explicit(&block->hashes[idx], &expected, busy_hash, memory_order_relaxed, memory_order_relaxed)) {
+            memcpy(block->keys + idx * key_size, key, key_size);
+            if (val_size != 0)
+                memcpy(block->vals + idx * val_size, val, val_size);
+            atomic_store_explicit(&block->hashes[idx], hash, memory_order_release);
+            atomic_fetch_add_explicit(&block->elem_count, 1, memory_order_relaxed);
+            return;
+        }
+    }
+}
+
+// Freezes the given range of buckets and copies their elements into the next block.
+static inline void concurrent_hash_table_migrate_chunk(
+    struct concurrent_hash_table_block* block,
+    struct concurrent_hash_table_block* next_block,
+    size_t begin,
+    size_t end,
+    size_t key_size,
+    size_t val_size)
+{
+    for (size_t i = begin; i < end; ++i) {
+        uint32_t hash = atomic_load_explicit(&block->hashes[i], memory_order_acquire);
+        while (true) {
+            if (hash & CONCURRENT_HASH_TABLE_BUSY_FLAG) {
+                hash = atomic_load_explicit(&block->hashes[i], memory_order_acquire);
+                continue;
+            }
+            if (atomic_compare_exchange_weak_explicit(
+                &block->hashes[i], &hash, hash | CONCURRENT_HASH_TABLE_MOVED_FLAG,
+                memory_order_acquire, memory_order_acquire))
+                break;
+        }
+        if (hash & HASH_TABLE_OCCUPIED_FLAG) {
+            concurrent_hash_table_place(
+                next_block,
+                block->keys + i * key_size,
+                val_size != 0 ? block->vals + i * val_size : NULL,
+                key_size, val_size, hash);
+        }
+    }
+    atomic_fetch_add_explicit(&block->migrated_count, end - begin, memory_order_acq_rel);
+}
+
+// Starts resizing the given block if that is not already the case, and helps migrating its
+// elements until they are all in the next block, which is then returned.
+static inline struct concurrent_hash_table_block* concurrent_hash_table_help_resize(
+    struct concurrent_hash_table* hash_table,
+    struct concurrent_hash_table_block* block,
+    size_t key_size,
+    size_t val_size)
+{
+    // Only the thread that marks the block as being resized allocates the next block, while the
+    // other threads wait for that block to be published.
+    struct concurrent_hash_table_block* next_block = atomic_load_explicit(&block->next, memory_order_acquire);
+    if (!next_block && atomic_compare_exchange_strong_explicit(
+        &block->next, &next_block, CONCURRENT_HASH_TABLE_RESIZING,
+        memory_order_acquire, memory_order_acquire))
+    {
+        next_block = concurrent_hash_table_alloc_block(key_size, val_size, block->capacity * 2);
+        atomic_store_explicit(&block->next, next_block, memory_order_release);
+    }
+    while (next_block == CONCURRENT_HASH_TABLE_RESIZING) {
+        concurrent_hash_table_yield();
+        next_block = atomic_load_explicit(&block->next, memory_order_acquire);
+    }
+
+    size_t begin;
+    while ((begin = atomic_fetch_add_explicit(&block->claimed_count, CONCURRENT_HASH_TABLE_MIGRATION_CHUNK, memory_order_relaxed)) < block->capacity) {
+        size_t end = block->capacity - begin > CONCURRENT_HASH_TABLE_MIGRATION_CHUNK
+            ? begin + CONCURRENT_HASH_TABLE_MIGRATION_CHUNK : block->capacity;
+        concurrent_hash_table_migrate_chunk(block, next_block, begin, end, key_size, val_size);
+    }
+    while (atomic_load_explicit(&block->migrated_count, memory_order_acquire) < block->capacity)
+        concurrent_hash_table_yield();
+
+    atomic_compare_exchange_strong_explicit(&hash_table->block, &block, next_block, memory_order_acq_rel, memory_order_relaxed);
+    return next_block;
+}
+
+static inline enum concurrent_hash_table_result concurrent_hash_table_insert_in_block(
+    struct concurrent_hash_table_block* block,
+    size_t* found_idx,
+    const void* key,
+    const void* val,
+    size_t key_size,
+    size_t val_size,
+    uint32_t hash,
+    bool (*is_equal) (const void*, const void*))
+{
+    uint32_t busy_hash = (hash & CONCURRENT_HASH_TABLE_HASH_MASK) | CONCURRENT_HASH_TABLE_BUSY_FLAG;
+    size_t idx = concurrent_hash_table_first_bucket(block, hash);
+    for (size_t i = 0; i < block->capacity; ++i, idx = concurrent_hash_table_next_bucket(block, idx)) {
+        uint32_t cur_hash = atomic_load_explicit(&block->hashes[idx], memory_order_acquire);
+        while (true) {
+            if (cur_hash & CONCURRENT_HASH_TABLE_MOVED_FLAG)
+                return CONCURRENT_HASH_TABLE_FROZEN;
+            if (cur_hash == 0) {
+                if (!atomic_compare_exchange_weak_explicit(
+                    &block->hashes[idx], &cur_hash, busy_hash,
+                    memory_order_acquire, memory_order_acquire))
+                    continue;
+                memcpy(block->keys + idx * key_size, key, key_size);
+                if (val_size != 0)
+                    memcpy(block->vals + idx * val_size, val, val_size);
+                atomic_store_explicit(&block->hashes[idx], hash, memory_order_release);
+                *found_idx = idx;
+                return CONCURRENT_HASH_TABLE_INSERTED;
+            }
+            if (cur_hash == busy_hash) {
+                // Another thread may be inserting the same key: Wait until it is visible.
+                cur_hash = atomic_load_explicit(&block->hashes[idx], memory_order_acquire);
+                continue;
+            }
+            if (cur_hash == hash && is_equal(block->keys + idx * key_size, key)) {
+                *found_idx = idx;
+                return CONCURRENT_HASH_TABLE_FOUND;
+            }
+            break;
+        }
+    }
+    return CONCURRENT_HASH_TABLE_FROZEN;
+}
+
+static inline bool concurrent_hash_table_find_in_block(
+    const struct concurrent_hash_table_block* block,
+    size_t* found_idx,
+    const void* key,
+    size_t key_size,
+    uint32_t hash,
+    bool (*is_equal) (const void*, const void*))
+{
+    size_t idx = concurrent_hash_table_first_bucket(block, hash);
+    for (size_t i = 0; i < block->capacity; ++i, idx = concurrent_hash_table_next_bucket(block, idx)) {
+        uint32_t cur_hash = atomic_load_explicit(&block->hashes[idx], memory_order_acquire);
+        if ((cur_hash & ~CONCURRENT_HASH_TABLE_MOVED_FLAG) == 0)
+            return false;
+        if ((cur_hash & ~CONCURRENT_HASH_TABLE_MOVED_FLAG) == hash && is_equal(block->keys + idx * key_size, key)) {
+            *found_idx = idx;
+            return true;
+        }
+    }
+    return false;
+}
+/// @endcond
+
+/// Creates a concurrent hash table. This function is not thread-safe.
+/// @param key_size Size of a key (in bytes)
+/// @param val_size Size of a value (in bytes)
+/// @param init_capacity Initial capacity (in number of elements)
+[[nodiscard]] static inline struct concurrent_hash_table concurrent_hash_table_create(
+    size_t key_size,
+    size_t val_size,
+    size_t init_capacity)
+{
+    assert(key_size > 0);
+    struct concurrent_hash_table_block* block = concurrent_hash_table_alloc_block(key_size, val_size, init_capacity);
+    struct concurrent_hash_table hash_table = { .first_block = block };
+    atomic_init(&hash_table.block, block);
+    return hash_table;
+}
+
+/// Destroys the given concurrent hash table. This function is not thread-safe.
+static inline void concurrent_hash_table_destroy(struct concurrent_hash_table* hash_table) {
+    for (struct concurrent_hash_table_block* block = hash_table->first_block; block;) {
+        struct concurrent_hash_table_block* next_block = atomic_load_explicit(&block->next, memory_order_relaxed);
+        free(block->hashes);
+        free(block->keys);
+        free(block->vals);
+        free(block);
+        block = next_block;
+    }
+    memset(hash_table, 0, sizeof(struct concurrent_hash_table));
+}
+
+/// @return The current block of the given concurrent hash table.
+[[nodiscard]] static inline struct concurrent_hash_table_block* concurrent_hash_table_block(
+    const struct concurrent_hash_table* hash_table)
+{
+    // The table itself is never modified, only the atomic pointer to its current block.
+    return atomic_load_explicit((_Atomic(struct concurrent_hash_table_block*)*)&hash_table->block, memory_order_acquire);
+}
+
+/// @return The number of elements in the concurrent hash table. The result is only approximate
+/// when other threads are inserting elements at the same time.
+[[nodiscard]] static inline size_t concurrent_hash_table_size(const struct concurrent_hash_table* hash_table) {
+    return atomic_load_explicit(&concurrent_hash_table_block(hash_table)->elem_count, memory_order_relaxed);
+}
+
+/// Finds an element in a concurrent hash table. This function is wait-free.
+/// @param found_block On success, contains the block where the element was found.
+/// @param found_idx On success, contains the index of the element in that block.
+/// @return `true` if the element was found, `false` otherwise.
+static inline bool concurrent_hash_table_find(
+    const struct concurrent_hash_table* hash_table,
+    const struct concurrent_hash_table_block** found_block,
+    size_t* found_idx,
+    const void* key,
+    size_t key_size,
+    uint32_t hash,
+    bool (*is_equal) (const void*, const void*))
+{
+    hash = (hash & CONCURRENT_HASH_TABLE_HASH_MASK) | HASH_TABLE_OCCUPIED_FLAG;
+    // No bucket is frozen before the next block is published, which means that the element can only
+    // be in the current block while that next block is being allocated.
+    for (const struct concurrent_hash_table_block* block = concurrent_hash_table_block(hash_table);
+        block && block != CONCURRENT_HASH_TABLE_RESIZING;
+        block = atomic_load_explicit(&block->next, memory_order_acquire))
+    {
+        if (concurrent_hash_table_find_in_block(block, found_idx, key, key_size, hash, is_equal)) {
+            *found_block = block;
+            return true;
+        }
+    }
+    return false;
+}
+
+/// Inserts an element into a concurrent hash table if no equal element exists, resizing the table
+/// if necessary. In both cases, the location of the element that is in the table is returned, which
+/// allows all threads that insert equal elements at the same time to agree on a single element. That
+/// location may belong to a block that has since been replaced, and must therefore only be read.
+/// @param found_block Contains the block where the element is located.
+/// @param found_idx Contains the index of the element in that block.
+/// @return `true` if the element was inserted, `false` if it already existed.
+static inline bool concurrent_hash_table_find_or_insert(
+    struct concurrent_hash_table* hash_table,
+    const struct concurrent_hash_table_block** found_block,
+    size_t* found_idx,
+    const void* key,
+    const void* val,
+    size_t key_size,
+    size_t val_size,
+    uint32_t hash,
+    bool (*is_equal) (const void*, const void*))
+{
+    hash = (hash & CONCURRENT_HASH_TABLE_HASH_MASK) | HASH_TABLE_OCCUPIED_FLAG;
+    struct concurrent_hash_table_block* block = concurrent_hash_table_block(hash_table);
+    while (true) {
+        switch (concurrent_hash_table_insert_in_block(block, found_idx, key, val, key_size, val_size, hash, is_equal)) {
+            case CONCURRENT_HASH_TABLE_INSERTED: {
+                *found_block = block;
+                size_t elem_count = atomic_fetch_add_explicit(&block->elem_count, 1, memory_order_relaxed) + 1;
+                if (elem_count * 100 >= block->capacity * HASH_TABLE_MAX_LOAD_FACTOR)
+                    concurrent_hash_table_help_resize(hash_table, block, key_size, val_size);
+                return true;
+            }
+            case CONCURRENT_HASH_TABLE_FOUND:
+                *found_block = block;
+                return false;
+            case CONCURRENT_HASH_TABLE_FROZEN:
+                block = concurrent_hash_table_help_resize(hash_table, block, key_size, val_size);
+                break;
+        }
+    }
+}
+
+/// Inserts an element into a concurrent hash table, resizing it if necessary.
+/// @return `true` if the element was inserted, `false` if it already existed.
+static inline bool concurrent_hash_table_insert(
+    struct concurrent_hash_table* hash_table,
+    const void* key,
+    const void* val,
+    size_t key_size,
+    size_t val_size,
+    uint32_t hash,
+    bool (*is_equal) (const void*, const void*))
+{
+    const struct concurrent_hash_table_block* block;
+    size_t idx;
+    return concurrent_hash_table_find_or_insert(hash_table, &block, &idx, key, val, key_size, val_size, hash, is_equal);
+}
+
+/// @return `true` if the given bucket of a block contains an element, `false` otherwise.
+[[nodiscard]] static inline bool concurrent_hash_table_is_bucket_occupied(
+    const struct concurrent_hash_table_block* block,
+    size_t bucket_idx)
+{
+    uint32_t hash = atomic_load_explicit(&block->hashes[bucket_idx], memory_order_acquire);
+    return (hash & (HASH_TABLE_OCCUPIED_FLAG | CONCURRENT_HASH_TABLE_MOVED_FLAG)) == HASH_TABLE_OCCUPIED_FLAG;
+}
@@ -0,0 +1,90 @@
+#pragma once
+
+#include "concurrent_hash_table.h"
+#include "visibility.h"
+#include "hash.h"
+
+/// @file
+///
+/// Hash map data structure supporting concurrent insertions and lookups from several threads.
+/// Lookups are wait-free, but insertions may wait for concurrent insertions of the same key to
+/// complete. When the map is resized, inserting threads cooperate to move the elements to a larger
+/// table. Values cannot be modified once inserted, and elements cannot be removed.
+/// @see concurrent_hash_table.
+
+/// @cond PRIVATE
+#define CONCURRENT_MAP_DEFAULT_CAPACITY 16
+#define CONCURRENT_MAP_PREFIX concurrent_map_very_long_prefix_
+/// @endcond
+
+/// Iterates over the keys and values of a concurrent map. This is not thread-safe, and should only
+/// be used when no other thread is inserting elements into the map.
+/// @param key_ty Type of the keys in the map.
+/// @param key Name of the variable holding a pointer to the current key.
+/// @param val_ty Type of the values in the map.
+/// @param val Name of the variable holding a pointer to the current value.
+/// @param map Expression evaluating to a concurrent map.
+#define CONCURRENT_MAP_FOREACH(key_ty, key, val_ty, val, map) \
+    for (const struct concurrent_hash_table_block* CONCURRENT_MAP_PREFIX##block = concurrent_hash_table_block(&(map).hash_table); \
+        CONCURRENT_MAP_PREFIX##block; CONCURRENT_MAP_PREFIX##block = NULL) \
+        for (size_t CONCURRENT_MAP_PREFIX##i = 0; CONCURRENT_MAP_PREFIX##i < CONCURRENT_MAP_PREFIX##block->capacity; ++CONCURRENT_MAP_PREFIX##i) \
+            if (concurrent_hash_table_is_bucket_occupied(CONCURRENT_MAP_PREFIX##block, CONCURRENT_MAP_PREFIX##i)) \
+                for (bool CONCURRENT_MAP_PREFIX##once = true; CONCURRENT_MAP_PREFIX##once; CONCURRENT_MAP_PREFIX##once = false) \
+                    for (key_ty const* key = &((key_ty const*)CONCURRENT_MAP_PREFIX##block->keys)[CONCURRENT_MAP_PREFIX##i]; CONCURRENT_MAP_PREFIX##once; CONCURRENT_MAP_PREFIX##once = false) \
+                        for (val_ty const* val = &((val_ty const*)CONCURRENT_MAP_PREFIX##block->vals)[CONCURRENT_MAP_PREFIX##i]; CONCURRENT_MAP_PREFIX##once; CONCURRENT_MAP_PREFIX##once = false)
+
+/// Declares and implements a concurrent hash map.
+/// @param name Name of the structure representing the hash map.
+/// @param key_ty Type of the keys in the hash map.
+/// @param val_ty Type of the values in the hash map.
+/// @param hash Hash function with signature `uint32 (uint32_t, const key_ty*)`
+/// @param is_equal Comparison function with signature `bool (const key_ty*, const key_ty*)`.
+/// @param vis Visibility of the implementation.
+/// @see VISIBILITY, CONCURRENT_MAP_DECL, CONCURRENT_MAP_IMPL.
+#define CONCURRENT_MAP_DEFINE(name, key_ty, val_ty, hash, is_equal, vis) \
+    CONCURRENT_MAP_DECL(name, key_ty, val_ty, vis) \
+    CONCURRENT_MAP_IMPL(name, key_ty, val_ty, hash, is_equal, vis)
+
+/// Declares a concurrent hash map. Typically used in header files.
+/// @see CONCURRENT_MAP_DEFINE.
+#define CONCURRENT_MAP_DECL(name, key_ty, val_ty, vis) \
+    struct name { \
+        struct concurrent_hash_table hash_table; \
+    }; \
+    [[nodiscard]] VISIBILITY(vis) struct name name##_create_with_capacity(size_t); \
+    [[nodiscard]] VISIBILITY(vis) struct name name##_create(void); \
+    VISIBILITY(vis) void name##_destroy(struct name*); \
+    VISIBILITY(vis) bool name##_insert(struct name*, key_ty const*, val_ty const*); \
+    [[nodiscard]] VISIBILITY(vis) size_t name##_size(const struct name*); \
+    VISIBILITY(vis) val_ty const* name##_find(const struct name*, key_ty const*);
+
+/// Implements a concurrent hash map. Typically used in source files.
+/// @see CONCURRENT_MAP_DEFINE.
+#define CONCURRENT_MAP_IMPL(name, key_ty, val_ty, hash, is_equal, vis) \
+    static inline bool name##_is_equal_wrapper(const void* left, const void* right) { \
+        return is_equal((key_ty const*)left, (key_ty const*)right); \
+    } \
+    VISIBILITY(vis) struct name name##_create_with_capacity(size_t capacity) { \
+        return (struct name) { \
+            .hash_table = concurrent_hash_table_create(sizeof(key_ty), sizeof(val_ty), capacity) \
+        }; \
+    } \
+    VISIBILITY(vis) struct name name##_create(void) { \
+        return name##_create_with_capacity(CONCURRENT_MAP_DEFAULT_CAPACITY); \
+    } \
+    VISIBILITY(vis) void name##_destroy(struct name* map) { \
+        concurrent_hash_table_destroy(&map->hash_table); \
+    } \
+    VISIBILITY(vis) bool name##_insert(struct name* map, key_ty const* key, val_ty const* val) { \
+        return concurrent_hash_table_insert(&map->hash_table, key, val, sizeof(key_ty), sizeof(val_ty), hash(hash_init(), key), name##_is_equal_wrapper); \
+    } \
+    VISIBILITY(vis) size_t name##_size(const struct name* map) { \
+        return concurrent_hash_table_size(&map->hash_table); \
+    } \
+    VISIBILITY(vis) val_ty const* name##_find(const struct name* map, key_ty const* key) { \
+        const struct concurrent_hash_table_block* block; \
+        size_t idx; \
+        if (!concurrent_hash_table_find(&map->hash_table, &block, &idx, key, sizeof(key_ty), hash(hash_init(), key), name##_is_equal_wrapper)) \
+            return NULL; \
+        return ((val_ty const*)block->vals) + idx; \
+    }
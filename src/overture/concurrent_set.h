@@ -0,0 +1,85 @@
+#pragma once
+
+#include "concurrent_hash_table.h"
+#include "visibility.h"
+#include "hash.h"
+
+/// @file
+///
+/// Hash set data structure supporting concurrent insertions and lookups from several threads.
+/// Lookups are wait-free, but insertions may wait for concurrent insertions of the same element to
+/// complete. Elements cannot be removed.
+/// @see concurrent_hash_table, concurrent_map.h.
+
+/// @cond PRIVATE
+#define CONCURRENT_SET_DEFAULT_CAPACITY 16
+#define CONCURRENT_SET_PREFIX concurrent_set_very_long_prefix_
+/// @endcond
+
+/// Iterates over the elements of a concurrent hash set. This is not thread-safe, and should only
+/// be used when no other thread is inserting elements into the set.
+/// @param elem_ty Type of the elements in the hash set.
+/// @param elem Name of the variable holding a pointer to the current element.
+/// @param set Expression evaluating to a concurrent hash set.
+#define CONCURRENT_SET_FOREACH(elem_ty, elem, set) \
+    for (const struct concurrent_hash_table_block* CONCURRENT_SET_PREFIX##block = concurrent_hash_table_block(&(set).hash_table); \
+        CONCURRENT_SET_PREFIX##block; CONCURRENT_SET_PREFIX##block = NULL) \
+        for (size_t CONCURRENT_SET_PREFIX##i = 0; CONCURRENT_SET_PREFIX##i < CONCURRENT_SET_PREFIX##block->capacity; ++CONCURRENT_SET_PREFIX##i) \
+            if (concurrent_hash_table_is_bucket_occupied(CONCURRENT_SET_PREFIX##block, CONCURRENT_SET_PREFIX##i)) \
+                for (bool CONCURRENT_SET_PREFIX##once = true; CONCURRENT_SET_PREFIX##once; CONCURRENT_SET_PREFIX##once = false) \
+                    for (elem_ty const* elem = &((elem_ty const*)CONCURRENT_SET_PREFIX##block->keys)[CONCURRENT_SET_PREFIX##i]; CONCURRENT_SET_PREFIX##once; CONCURRENT_SET_PREFIX##once = false)
+
+/// Declares and implements a concurrent hash set.
+/// @param name Name of the structure representing the hash set.
+/// @param elem_ty Type of the elements in the hash set.
+/// @param hash Hash function with signature `uint32 (uint32_t, const elem_ty*)`
+/// @param is_equal Comparison function with signature `bool (const elem_ty*, const elem_ty*)`.
+/// @param vis Visibility of the implementation.
+/// @see VISIBILITY, CONCURRENT_SET_DECL, CONCURRENT_SET_IMPL.
+#define CONCURRENT_SET_DEFINE(name, elem_ty, hash, is_equal, vis) \
+    CONCURRENT_SET_DECL(name, elem_ty, vis) \
+    CONCURRENT_SET_IMPL(name, elem_ty, hash, is_equal, vis)
+
+/// Declares a concurrent hash set. Typically used in header files.
+/// @see CONCURRENT_SET_DEFINE.
+#define CONCURRENT_SET_DECL(name, elem_ty, vis) \
+    struct name { \
+        struct concurrent_hash_table hash_table; \
+    }; \
+    [[nodiscard]] VISIBILITY(vis) struct name name##_create_with_capacity(size_t); \
+    [[nodiscard]] VISIBILITY(vis) struct name name##_create(void); \
+    VISIBILITY(vis) void name##_destroy(struct name*); \
+    VISIBILITY(vis) bool name##_insert(struct name*, elem_ty const*); \
+    [[nodiscard]] VISIBILITY(vis) size_t name##_size(const struct name*); \
+    VISIBILITY(vis) elem_ty const* name##_find(const struct name*, elem_ty const*);
+
+/// Implements a concurrent hash set. Typically used in source files.
+/// @see CONCURRENT_SET_DEFINE.
+#define CONCURRENT_SET_IMPL(name, elem_ty, hash, is_equal, vis) \
+    static inline bool name##_is_equal_wrapper(const void* left, const void* right) { \
+        return is_equal((elem_ty const*)left, (elem_ty const*)right); \
+    } \
+    VISIBILITY(vis) struct name name##_create_with_capacity(size_t capacity) { \
+        return (struct name) { \
+            .hash_table = concurrent_hash_table_create(sizeof(elem_ty), 0, capacity) \
+        }; \
+    } \
+    VISIBILITY(vis) struct name name##_create(void) { \
+        return name##_create_with_capacity(CONCURRENT_SET_DEFAULT_CAPACITY); \
+    } \
+    VISIBILITY(vis) void name##_destroy(struct name* set) { \
+        concurrent_hash_table_destroy(&set->hash_table); \
+    } \
+    VISIBILITY(vis) bool name##_insert(struct name* set, elem_ty const* elem) { \
+        return concurrent_hash_table_insert(&set->hash_table, elem, NULL, sizeof(elem_ty), 0, hash(hash_init(), elem), name##_is_equal_wrapper); \
+    } \
+    VISIBILITY(vis) size_t name##_size(const struct name* set) { \
+        return concurrent_hash_table_size(&set->hash_table); \
+    } \
+    VISIBILITY(vis) elem_ty const* name##_find(const struct name* set, elem_ty const* elem) { \
+        const struct concurrent_hash_table_block* block; \
+        size_t idx; \
+        if (!concurrent_hash_table_find(&set->hash_table, &block, &idx, elem, sizeof(elem_ty), hash(hash_init(), elem), name##_is_equal_wrapper)) \
+            return NULL; \
+        return ((elem_ty const*)block->keys) + idx; \
+    }
@@ -0,0 +1,92 @@
+#include "concurrent_str_pool.h"
+#include "concurrent_hash_table.h"
+#include "mem_pool.h"
+#include "mem.h"
+
+#include <string.h>
+#include <assert.h>
+
+#define CONCURRENT_STR_POOL_DEFAULT_CAPACITY 1024
+
+struct concurrent_str_pool {
+    struct concurrent_hash_table hash_table;
+};
+
+static inline bool is_pool_str_equal(const void* left, const void* right) {
+    const char* str = *(const char* const*)left;
+    const char* other = *(const char* const*)right;
+    return
+        str == other || (
+        str_pool_length(str) == str_pool_length(other) &&
+        !memcmp(str, other, str_pool_length(str)));
+}
+
+static inline bool is_pool_str_equal_to_view(const void* left, const void* right) {
+    const char* str = *(const char* const*)left;
+    const struct str_view* str_view = right;
+    return
+        str_pool_length(str) == str_view->length &&
+        !memcmp(str, str_view->data, str_view->length);
+}
+
+struct concurrent_str_pool* concurrent_str_pool_create(void) {
+    struct concurrent_str_pool* str_pool = xmalloc(sizeof(struct concurrent_str_pool));
+    str_pool->hash_table = concurrent_hash_table_create(sizeof(const char*), 0, CONCURRENT_STR_POOL_DEFAULT_CAPACITY);
+    return str_pool;
+}
+
+void concurrent_str_pool_destroy(struct concurrent_str_pool* str_pool) {
+    concurrent_hash_table_destroy(&str_pool->hash_table);
+    free(str_pool);
+}
+
+const char* concurrent_str_pool_find(const struct concurrent_str_pool* str_pool, const char* str) {
+    return concurrent_str_pool_find_view(str_pool, STR_VIEW(str));
+}
+
+const char* concurrent_str_pool_find_view(const struct concurrent_str_pool* str_pool, struct str_view str_view) {
+    const struct concurrent_hash_table_block* block;
+    size_t idx;
+    if (!concurrent_hash_table_find(&str_pool->hash_table, &block, &idx, &str_view,
+        sizeof(const char*), str_view_hash(hash_init(), &str_view), is_pool_str_equal_to_view))
+        return NULL;
+    return *(const char* const*)(block->keys + idx * sizeof(const char*));
+}
+
+const char* concurrent_str_pool_insert(struct concurrent_str_pool* str_pool, struct mem_pool* mem_pool, const char* str) {
+    return concurrent_str_pool_insert_view(str_pool, mem_pool, STR_VIEW(str));
+}
+
+const char* concurrent_str_pool_insert_view(
+    struct concurrent_str_pool* str_pool,
+    struct mem_pool* mem_pool,
+    struct str_view str_view)
+{
+    uint32_t hash = str_view_hash(hash_init(), &str_view);
+    const struct concurrent_hash_table_block* block;
+    size_t idx;
+    if (concurrent_hash_table_find(&str_pool->hash_table, &block, &idx, &str_view,
+        sizeof(const char*), hash, is_pool_str_equal_to_view))
+        return *(const char* const*)(block->keys + idx * sizeof(const char*));
+
+    assert(str_view.length <= UINT32_MAX);
+    struct str_pool_header* header = mem_pool_alloc(mem_pool,
+        sizeof(struct str_pool_header) + str_view.length + 1, alignof(struct str_pool_header));
+    header->hash = hash;
+    header->length = (uint32_t)str_view.length;
+    header->id = STR_POOL_INVALID_ID;
+    char* data = (char*)(header + 1);
+    xmemcpy(data, str_view.data, str_view.length);
+    data[str_view.length] = 0;
+
+    // Another thread may have inserted the same string in the meantime, in which case the copy
+    // made by this thread is simply left unused in its memory pool.
+    const char* key = data;
+    concurrent_hash_table_find_or_insert(&str_pool->hash_table, &block, &idx, &key, NULL,
+        sizeof(const char*), 0, hash, is_pool_str_equal);
+    return *(const char* const*)(block->keys + idx * sizeof(const char*));
+}
+
+size_t concurrent_str_pool_size(const struct concurrent_str_pool* str_pool) {
+    return concurrent_hash_table_size(&str_pool->hash_table);
+}
@@ -0,0 +1,48 @@
+#pragma once
+
+#include "str_pool.h"
+
+/// @file
+///
+/// Concurrent string pool data structure, which supports lookups and insertions from several
+/// threads at the same time. Just like with @ref str_pool.h, inserting twice the same string yields
+/// the same pointer, even when both insertions happen in different threads, and strings are
+/// preceded by a @ref str_pool_header, such that @ref str_pool_hash, @ref str_pool_length, and
+/// @ref str_pool_view can be used on them. Strings of a concurrent string pool do not have an id,
+/// since threads may give up the copy of a string that they allocated.
+///
+/// The characters of the strings are allocated from a memory pool passed by the inserting thread.
+/// Since memory pools are not thread-safe, each thread should use its own memory pool, which must
+/// outlive the string pool. Lookups are wait-free, but insertions may wait for concurrent insertions
+/// of the same string to complete (see @ref concurrent_hash_table.h).
+
+struct concurrent_str_pool;
+struct mem_pool;
+
+/// Creates an empty concurrent string pool. This function is not thread-safe.
+[[nodiscard]] struct concurrent_str_pool* concurrent_str_pool_create(void);
+
+/// Destroys a concurrent string pool. This function is not thread-safe.
+void concurrent_str_pool_destroy(struct concurrent_str_pool*);
+
+/// Finds a `NULL`-terminated string in a concurrent string pool.
+/// @return If it exists, the `NULL`-terminated string in the pool that is equal to the argument, or NULL otherwise.
+const char* concurrent_str_pool_find(const struct concurrent_str_pool*, const char*);
+
+/// Finds a string view in a concurrent string pool.
+/// @return If it exists, the `NULL`-terminated string in the pool that is equal to the argument, or NULL otherwise.
+const char* concurrent_str_pool_find_view(const struct concurrent_str_pool*, struct str_view);
+
+/// Inserts a `NULL`-terminated string in a concurrent string pool.
+/// @param mem_pool Memory pool of the calling thread, used if the string is not yet in the pool.
+/// @return A `NULL`-terminated string allocated from the memory pool of one of the inserting threads.
+const char* concurrent_str_pool_insert(struct concurrent_str_pool*, struct mem_pool* mem_pool, const char*);
+
+/// Inserts a string view in a concurrent string pool.
+/// @param mem_pool Memory pool of the calling thread, used if the string is not yet in the pool.
+/// @return A `NULL`-terminated string allocated from the memory pool of one of the inserting threads.
+const char* concurrent_str_pool_insert_view(struct concurrent_str_pool*, struct mem_pool* mem_pool, struct str_view);
+
+/// @return The number of strings in the pool. The result is only approximate when other threads
+/// are inserting strings at the same time.
+[[nodiscard]] size_t concurrent_str_pool_size(const struct concurrent_str_pool*);
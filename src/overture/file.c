@@ -17,6 +17,12 @@
 #include <unistd.h>
 #endif
 
+#if defined (__unix__) || (defined (__APPLE__) && defined (__MACH__))
+#include <sys/mman.h>
+#include <fcntl.h>
+#define HAS_MMAP
+#endif
+
 char* read_file(const char* file_name, size_t* total_size) {
     FILE* file = fopen(file_name, "rb");
     if (!file)
@@ -47,6 +53,48 @@ char* read_file(const char* file_name, size_t* total_size) {
     return data;
 }
 
+bool map_file(const char* file_name, struct mapped_file* mapped_file) {
+#ifdef HAS_MMAP
+    int fd = open(file_name, O_RDONLY);
+    if (fd < 0)
+        return false;
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        close(fd);
+        return false;
+    }
+    if (st.st_size == 0) {
+        // Empty files cannot be mapped.
+        close(fd);
+        *mapped_file = (struct mapped_file) { .data = "" };
+        return true;
+    }
+    void* data = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED)
+        return false;
+    *mapped_file = (struct mapped_file) { .data = data, .size = st.st_size, .is_mapped = true };
+    return true;
+#else
+    size_t size = 0;
+    char* data = read_file(file_name, &size);
+    if (!data)
+        return false;
+    *mapped_file = (struct mapped_file) { .data = data, .size = size };
+    return true;
+#endif
+}
+
+void unmap_file(struct mapped_file* mapped_file) {
+#ifdef HAS_MMAP
+    if (mapped_file->is_mapped)
+        munmap((void*)mapped_file->data, mapped_file->size);
+#else
+    free((char*)mapped_file->data);
+#endif
+    memset(mapped_file, 0, sizeof(struct mapped_file));
+}
+
 bool file_exists(const char* file_name) {
     return access(file_name, F_OK) == 0;
 }
@@ -85,21 +133,20 @@ bool is_path_sep(char c) {
 }
 
 struct file_path split_path(struct str_view file_name) {
-    size_t dir_end   = 0;
-    size_t ext_begin = file_name.length;
-    for (size_t i = file_name.length; i-- > 0; ) {
-        if (is_path_sep(file_name.data[i])) {
-            dir_end = i;
-            break;
-        }
-
-        if (file_name.data[i] == '.')
-            ext_begin = i;
-    }
+    // Adding one maps a missing separator (`STR_VIEW_NOT_FOUND`) to the beginning of the path.
+    size_t base_begin = str_view_find_last_char(file_name, '/') + 1;
+#if WIN32
+    size_t backslash = str_view_find_last_char(file_name, '\\') + 1;
+    base_begin = backslash > base_begin ? backslash : base_begin;
+#endif
+    struct str_view base_and_ext = str_view_shrink(file_name, base_begin, 0);
+    size_t ext_begin = str_view_find_char(base_and_ext, '.');
+    if (ext_begin == STR_VIEW_NOT_FOUND)
+        ext_begin = base_and_ext.length;
 
     return (struct file_path) {
-        .dir_name  = { .data = file_name.data,               .length = dir_end },
-        .base_name = { .data = file_name.data + dir_end + 1, .length = ext_begin - dir_end - 1 },
-        .ext       = { .data = file_name.data + ext_begin,   .length = file_name.length - ext_begin },
+        .dir_name  = str_view_substr(file_name, 0, base_begin > 0 ? base_begin - 1 : 0),
+        .base_name = str_view_substr(base_and_ext, 0, ext_begin),
+        .ext       = str_view_shrink(base_and_ext, ext_begin, 0),
     };
 }
@@ -16,6 +16,23 @@
 /// @return A `NULL`-terminated buffer with the contents of the file, or `NULL` if reading fails. Must be freed using `free()` by the caller.
 [[nodiscard]] char* read_file(const char* file_name, size_t* total_size);
 
+/// File whose contents are mapped in memory.
+struct mapped_file {
+    const char* data;   ///< Contents of the file, which must not be modified.
+    size_t size;        ///< Size of the file, in bytes.
+    bool is_mapped;     ///< `true` if the file is mapped with `mmap`, `false` if it was read in memory.
+};
+
+/// Maps the contents of a file in memory, or reads them when memory mapping is not available on the
+/// platform. The contents of the file are not guaranteed to be `NULL`-terminated.
+/// @param file_name Name of the file on disk.
+/// @param mapped_file On success, contains the contents of the file.
+/// @return `true` on success, otherwise `false`.
+[[nodiscard]] bool map_file(const char* file_name, struct mapped_file* mapped_file);
+
+/// Unmaps a file mapped with @ref map_file.
+void unmap_file(struct mapped_file*);
+
 /// @return `true` if the given file exists, otherwise `false`.
 [[nodiscard]] bool file_exists(const char* file_name);
 
@@ -31,28 +31,17 @@ static inline bool is_graph_node_equal(
     return (*node_ptr)->key == (*other_ptr)->key;
 }
 
-static inline bool is_graph_node_ptr_equal(
-    struct graph_node* const* node_ptr,
-    struct graph_node* const* other_ptr)
-{
-    return *node_ptr == *other_ptr;
-}
-
 static inline uint32_t hash_raw_ptr(uint32_t h, void* const* ptr) {
     return hash_uint64(h, (uintptr_t)*ptr);
 }
 
-static inline bool is_raw_ptr_equal(void* const* ptr, void* const* other) {
-    return *ptr == *other;
-}
-
 SET_IMPL(graph_node_set, struct graph_node*, hash_graph_node, is_graph_node_equal, PUBLIC)
 SET_IMPL(graph_edge_set, struct graph_edge*, hash_graph_edge, is_graph_edge_equal, PUBLIC)
-MAP_IMPL(graph_node_map, struct graph_node*, void*, hash_graph_node, is_graph_node_ptr_equal, PUBLIC)
+MAP_IMPL_TRIVIAL(graph_node_map, struct graph_node*, void*, hash_graph_node, PUBLIC)
 VEC_IMPL(graph_node_vec, struct graph_node*, PUBLIC)
 SMALL_VEC_IMPL(small_graph_node_vec, struct graph_node*, PUBLIC)
 
-MAP_IMPL(graph_node_key_map, void*, struct graph_node*, hash_raw_ptr, is_raw_ptr_equal, PUBLIC)
+MAP_IMPL_TRIVIAL(graph_node_key_map, void*, struct graph_node*, hash_raw_ptr, PUBLIC)
 
 enum graph_dir graph_dir_reverse(enum graph_dir dir) {
     return dir == GRAPH_DIR_FORWARD ? GRAPH_DIR_BACKWARD : GRAPH_DIR_FORWARD;
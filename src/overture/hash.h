@@ -2,12 +2,44 @@
 
 #include "bits.h"
 
+#include <stddef.h>
 #include <stdint.h>
+#include <string.h>
+#include <time.h>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#if (defined (__unix__) || (defined (__APPLE__) && defined (__MACH__))) && __has_include(<sys/random.h>)
+#include <sys/types.h>
+#include <sys/random.h>
+#define HASH_HAS_GETENTROPY
+#endif
 
 /// @file
 ///
-/// FNV-1a hash function, for bytes, words, double words, quad words, floating-point numbers, and
-/// strings.
+/// Hash functions, for bytes, words, double words, quad words, floating-point numbers, strings, and
+/// arbitrary memory regions. Three families are provided, with the same chaining signature
+/// `uint32_t (uint32_t, ...)` and the same initial value @ref hash_init:
+///
+/// - `hash_*` functions implement FNV-1a, which processes one byte at a time,
+/// - `hash_fast_*` functions process 64 bits at a time using 128-bit multiplications (similar to
+///   wyhash), and switch to a vectorized accumulation loop for large inputs (similar to XXH3),
+/// - `hash_sip_*` functions implement SipHash-1-3, a keyed hash function whose key is derived from
+///   the initial value.
+///
+/// The `hash_fast_*` functions are much faster than the `hash_*` functions on large keys, and also
+/// mix their input better. The families produce different values, and should therefore not be mixed
+/// for the same key type. The values produced by the `hash_fast_*` and `hash_sip_*` functions depend
+/// on the endianness of the machine.
+///
+/// All these functions are deterministic when started from @ref hash_init. When keys come from an
+/// untrusted source, an attacker can craft keys that all have the same hash, which makes hash table
+/// operations take linear time. To prevent this, hash tables can start hashing from a random value
+/// instead, obtained with @ref hash_random_seed (see @ref HASH_TABLE_SEEDED). Only the `hash_sip_*`
+/// functions are designed to resist such attacks when the initial value is kept secret: FNV-1a and
+/// the fast functions have collisions that do not depend on the initial value.
 
 [[nodiscard]] static inline uint32_t hash_init(void) {
     return 0x811c9dc5;
@@ -42,3 +74,313 @@
         h = hash_uint8(h, *str);
     return h;
 }
+
+[[nodiscard]] static inline uint32_t hash_bytes(uint32_t h, const void* data, size_t size) {
+    const uint8_t* bytes = data;
+    for (size_t i = 0; i < size; ++i)
+        h = hash_uint8(h, bytes[i]);
+    return h;
+}
+
+/// @cond PRIVATE
+#define HASH_FAST_K0 UINT64_C(0xa0761d6478bd642f)
+#define HASH_FAST_K1 UINT64_C(0xe7037ed1a0b428db)
+#define HASH_FAST_K2 UINT64_C(0x8ebc6af09c88c6e3)
+#define HASH_FAST_K3 UINT64_C(0x589965cc75374cc3)
+#define HASH_FAST_LANE_COUNT 8
+#define HASH_FAST_STRIPE_SIZE (HASH_FAST_LANE_COUNT * sizeof(uint64_t))
+#define HASH_FAST_BLOCK_STRIPES 16
+#define HASH_FAST_BULK_THRESHOLD 256
+
+static const uint64_t hash_fast_lane_keys[HASH_FAST_LANE_COUNT] = {
+    UINT64_C(0x9e3779b185ebca87), UINT64_C(0xc2b2ae3d27d4eb4f),
+    UINT64_C(0x165667b19e3779f9), UINT64_C(0x85ebca77c2b2ae63),
+    UINT64_C(0x27d4eb2f165667c5), UINT64_C(0x1d8e4e27c47d124f),
+    UINT64_C(0x94d049bb133111eb), UINT64_C(0xbf58476d1ce4e5b9)
+};
+
+// Multiplies two 64-bit numbers and folds the 128-bit result.
+static inline uint64_t hash_fast_mum(uint64_t a, uint64_t b) {
+#if defined(__SIZEOF_INT128__)
+    __extension__ unsigned __int128 r = (unsigned __int128)a * b;
+    return (uint64_t)r ^ (uint64_t)(r >> 64);
+#else
+    uint64_t ha = a >> 32, hb = b >> 32, la = (uint32_t)a, lb = (uint32_t)b;
+    uint64_t rh = ha * hb, rm0 = ha * lb, rm1 = hb * la, rl = la * lb;
+    uint64_t t = rl + (rm0 << 32);
+    uint64_t lo = t + (rm1 << 32);
+    uint64_t hi = rh + (rm0 >> 32) + (rm1 >> 32) + (t < rl) + (lo < t);
+    return lo ^ hi;
+#endif
+}
+
+static inline uint64_t hash_fast_read64(const uint8_t* bytes) {
+    uint64_t x;
+    memcpy(&x, bytes, sizeof(x));
+    return x;
+}
+
+static inline uint64_t hash_fast_read32(const uint8_t* bytes) {
+    uint32_t x;
+    memcpy(&x, bytes, sizeof(x));
+    return x;
+}
+
+static inline uint64_t hash_fast_seed(uint32_t h) {
+    return ((uint64_t)h << 32 | h) ^ HASH_FAST_K0;
+}
+
+static inline uint32_t hash_fast_finish(uint64_t a, uint64_t b, uint64_t seed, size_t size) {
+    uint64_t x = hash_fast_mum(HASH_FAST_K1 ^ size, hash_fast_mum(a ^ HASH_FAST_K1, b ^ seed));
+    return (uint32_t)(x ^ (x >> 32));
+}
+
+// Accumulates stripes of 64 bytes into 8 independent lanes. Each lane adds the product of the low
+// and high halves of its input (combined with a key that changes for every stripe, so that the
+// result depends on the order of the stripes), and the input of the neighboring lane.
+static inline void hash_fast_accumulate_scalar(
+    uint64_t* restrict acc,
+    uint64_t* restrict keys,
+    const uint8_t* bytes,
+    size_t stripe_count)
+{
+    for (size_t i = 0; i < stripe_count; ++i, bytes += HASH_FAST_STRIPE_SIZE) {
+        for (size_t j = 0; j < HASH_FAST_LANE_COUNT; ++j) {
+            uint64_t data = hash_fast_read64(bytes + j * sizeof(uint64_t));
+            uint64_t data_key = data ^ keys[j];
+            acc[j ^ 1] += data;
+            acc[j] += (data_key & UINT32_MAX) * (data_key >> 32);
+            keys[j] += HASH_FAST_K3;
+        }
+    }
+}
+
+#if defined(__SSE2__)
+static inline void hash_fast_accumulate(
+    uint64_t* restrict acc,
+    uint64_t* restrict keys,
+    const uint8_t* bytes,
+    size_t stripe_count)
+{
+    __m128i acc_lanes[HASH_FAST_LANE_COUNT / 2];
+    __m128i key_lanes[HASH_FAST_LANE_COUNT / 2];
+    const __m128i step = _mm_set1_epi64x((long long)HASH_FAST_K3);
+    for (size_t j = 0; j < HASH_FAST_LANE_COUNT / 2; ++j) {
+        acc_lanes[j] = _mm_loadu_si128((const __m128i*)(acc + j * 2));
+        key_lanes[j] = _mm_loadu_si128((const __m128i*)(keys + j * 2));
+    }
+    for (size_t i = 0; i < stripe_count; ++i, bytes += HASH_FAST_STRIPE_SIZE) {
+        for (size_t j = 0; j < HASH_FAST_LANE_COUNT / 2; ++j) {
+            __m128i data = _mm_loadu_si128((const __m128i*)(bytes + j * 16));
+            __m128i data_key = _mm_xor_si128(data, key_lanes[j]);
+            __m128i product = _mm_mul_epu32(data_key, _mm_shuffle_epi32(data_key, _MM_SHUFFLE(0, 3, 0, 1)));
+            __m128i swapped = _mm_shuffle_epi32(data, _MM_SHUFFLE(1, 0, 3, 2));
+            acc_lanes[j] = _mm_add_epi64(acc_lanes[j], _mm_add_epi64(product, swapped));
+            key_lanes[j] = _mm_add_epi64(key_lanes[j], step);
+        }
+    }
+    for (size_t j = 0; j < HASH_FAST_LANE_COUNT / 2; ++j) {
+        _mm_storeu_si128((__m128i*)(acc + j * 2), acc_lanes[j]);
+        _mm_storeu_si128((__m128i*)(keys + j * 2), key_lanes[j]);
+    }
+}
+#else
+static inline void hash_fast_accumulate(
+    uint64_t* restrict acc,
+    uint64_t* restrict keys,
+    const uint8_t* bytes,
+    size_t stripe_count)
+{
+    hash_fast_accumulate_scalar(acc, keys, bytes, stripe_count);
+}
+#endif
+
+// Hashes the given number of stripes, and returns the new seed.
+static inline uint64_t hash_fast_bulk(uint64_t seed, const uint8_t* bytes, size_t stripe_count) {
+    uint64_t acc[HASH_FAST_LANE_COUNT];
+    uint64_t keys[HASH_FAST_LANE_COUNT];
+    for (size_t j = 0; j < HASH_FAST_LANE_COUNT; ++j) {
+        acc[j] = hash_fast_lane_keys[j] ^ seed;
+        keys[j] = hash_fast_lane_keys[j];
+    }
+    while (stripe_count > HASH_FAST_BLOCK_STRIPES) {
+        hash_fast_accumulate(acc, keys, bytes, HASH_FAST_BLOCK_STRIPES);
+        // Scramble the accumulators so that the high bits of the products propagate to low bits.
+        for (size_t j = 0; j < HASH_FAST_LANE_COUNT; ++j) {
+            acc[j] ^= acc[j] >> 47;
+            acc[j] ^= hash_fast_lane_keys[j];
+            acc[j] *= UINT64_C(0x9e3779b1);
+        }
+        bytes += HASH_FAST_BLOCK_STRIPES * HASH_FAST_STRIPE_SIZE;
+        stripe_count -= HASH_FAST_BLOCK_STRIPES;
+    }
+    hash_fast_accumulate(acc, keys, bytes, stripe_count);
+    for (size_t j = 0; j < HASH_FAST_LANE_COUNT; j += 2)
+        seed = hash_fast_mum(acc[j] ^ HASH_FAST_K1, acc[j + 1] ^ seed);
+    return seed;
+}
+/// @endcond
+
+[[nodiscard]] static inline uint32_t hash_fast_uint64(uint32_t h, uint64_t x) {
+    return hash_fast_finish(x, x >> 32, hash_fast_seed(h), sizeof(x));
+}
+
+[[nodiscard]] static inline uint32_t hash_fast_uint8(uint32_t h, uint8_t x) {
+    return hash_fast_uint64(h, x);
+}
+
+[[nodiscard]] static inline uint32_t hash_fast_uint16(uint32_t h, uint16_t x) {
+    return hash_fast_uint64(h, x);
+}
+
+[[nodiscard]] static inline uint32_t hash_fast_uint32(uint32_t h, uint32_t x) {
+    return hash_fast_uint64(h, x);
+}
+
+[[nodiscard]] static inline uint32_t hash_fast_float(uint32_t h, float x) {
+    return hash_fast_uint32(h, float_to_bits(x));
+}
+
+[[nodiscard]] static inline uint32_t hash_fast_double(uint32_t h, double x) {
+    return hash_fast_uint64(h, double_to_bits(x));
+}
+
+[[nodiscard]] static inline uint32_t hash_fast_bytes(uint32_t h, const void* data, size_t size) {
+    const uint8_t* bytes = data;
+    uint64_t seed = hash_fast_seed(h);
+    uint64_t a = 0, b = 0;
+    if (size <= 16) {
+        // Small inputs are read with overlapping loads, which avoids loops and branches on the size.
+        if (size >= 4) {
+            size_t offset = (size >> 3) << 2;
+            a = hash_fast_read32(bytes) << 32 | hash_fast_read32(bytes + offset);
+            b = hash_fast_read32(bytes + size - 4) << 32 | hash_fast_read32(bytes + size - 4 - offset);
+        } else if (size > 0) {
+            a = (uint64_t)bytes[0] << 16 | (uint64_t)bytes[size >> 1] << 8 | bytes[size - 1];
+        }
+        return hash_fast_finish(a, b, seed, size);
+    }
+
+    size_t remaining = size;
+    if (remaining >= HASH_FAST_BULK_THRESHOLD) {
+        size_t stripe_count = remaining / HASH_FAST_STRIPE_SIZE;
+        seed = hash_fast_bulk(seed, bytes, stripe_count);
+        bytes += stripe_count * HASH_FAST_STRIPE_SIZE;
+        remaining -= stripe_count * HASH_FAST_STRIPE_SIZE;
+    }
+    if (remaining > 48) {
+        // Three independent lanes, so that the multiplications can run in parallel.
+        uint64_t seed1 = seed, seed2 = seed;
+        do {
+            seed  = hash_fast_mum(hash_fast_read64(bytes)      ^ HASH_FAST_K1, hash_fast_read64(bytes + 8)  ^ seed);
+            seed1 = hash_fast_mum(hash_fast_read64(bytes + 16) ^ HASH_FAST_K2, hash_fast_read64(bytes + 24) ^ seed1);
+            seed2 = hash_fast_mum(hash_fast_read64(bytes + 32) ^ HASH_FAST_K3, hash_fast_read64(bytes + 40) ^ seed2);
+            bytes += 48;
+            remaining -= 48;
+        } while (remaining > 48);
+        seed ^= seed1 ^ seed2;
+    }
+    while (remaining > 16) {
+        seed = hash_fast_mum(hash_fast_read64(bytes) ^ HASH_FAST_K1, hash_fast_read64(bytes + 8) ^ seed);
+        bytes += 16;
+        remaining -= 16;
+    }
+    // The last 16 bytes may overlap with bytes that were already hashed, since the input is larger
+    // than 16 bytes.
+    a = hash_fast_read64(bytes + remaining - 16);
+    b = hash_fast_read64(bytes + remaining - 8);
+    return hash_fast_finish(a, b, seed, size);
+}
+
+[[nodiscard]] static inline uint32_t hash_fast_string(uint32_t h, const char* str) {
+    return hash_fast_bytes(h, str, strlen(str));
+}
+
+/// @cond PRIVATE
+static inline uint64_t hash_sip_rotate(uint64_t x, unsigned n) {
+    return (x << n) | (x >> (64 - n));
+}
+
+static inline void hash_sip_round(uint64_t* v) {
+    v[0] += v[1]; v[1] = hash_sip_rotate(v[1], 13); v[1] ^= v[0]; v[0] = hash_sip_rotate(v[0], 32);
+    v[2] += v[3]; v[3] = hash_sip_rotate(v[3], 16); v[3] ^= v[2];
+    v[0] += v[3]; v[3] = hash_sip_rotate(v[3], 21); v[3] ^= v[0];
+    v[2] += v[1]; v[1] = hash_sip_rotate(v[1], 17); v[1] ^= v[2]; v[2] = hash_sip_rotate(v[2], 32);
+}
+/// @endcond
+
+[[nodiscard]] static inline uint32_t hash_sip_bytes(uint32_t h, const void* data, size_t size) {
+    const uint8_t* bytes = data;
+    // The 128-bit key is derived from the initial value.
+    uint64_t k0 = hash_fast_seed(h);
+    uint64_t k1 = (uint64_t)h * UINT64_C(0x9e3779b97f4a7c15) ^ HASH_FAST_K2;
+    uint64_t v[4] = {
+        k0 ^ UINT64_C(0x736f6d6570736575),
+        k1 ^ UINT64_C(0x646f72616e646f6d),
+        k0 ^ UINT64_C(0x6c7967656e657261),
+        k1 ^ UINT64_C(0x7465646279746573)
+    };
+    size_t i = 0;
+    for (; i + 8 <= size; i += 8) {
+        uint64_t m = hash_fast_read64(bytes + i);
+        v[3] ^= m;
+        hash_sip_round(v);
+        v[0] ^= m;
+    }
+    uint64_t last = (uint64_t)size << 56;
+    for (size_t j = 0; i + j < size; ++j)
+        last |= (uint64_t)bytes[i + j] << (j * 8);
+    v[3] ^= last;
+    hash_sip_round(v);
+    v[0] ^= last;
+    v[2] ^= 0xff;
+    hash_sip_round(v);
+    hash_sip_round(v);
+    hash_sip_round(v);
+    uint64_t x = v[0] ^ v[1] ^ v[2] ^ v[3];
+    return (uint32_t)(x ^ (x >> 32));
+}
+
+[[nodiscard]] static inline uint32_t hash_sip_uint8(uint32_t h, uint8_t x) {
+    return hash_sip_bytes(h, &x, sizeof(x));
+}
+
+[[nodiscard]] static inline uint32_t hash_sip_uint16(uint32_t h, uint16_t x) {
+    return hash_sip_bytes(h, &x, sizeof(x));
+}
+
+[[nodiscard]] static inline uint32_t hash_sip_uint32(uint32_t h, uint32_t x) {
+    return hash_sip_bytes(h, &x, sizeof(x));
+}
+
+[[nodiscard]] static inline uint32_t hash_sip_uint64(uint32_t h, uint64_t x) {
+    return hash_sip_bytes(h, &x, sizeof(x));
+}
+
+[[nodiscard]] static inline uint32_t hash_sip_float(uint32_t h, float x) {
+    return hash_sip_uint32(h, float_to_bits(x));
+}
+
+[[nodiscard]] static inline uint32_t hash_sip_double(uint32_t h, double x) {
+    return hash_sip_uint64(h, double_to_bits(x));
+}
+
+[[nodiscard]] static inline uint32_t hash_sip_string(uint32_t h, const char* str) {
+    return hash_sip_bytes(h, str, strlen(str));
+}
+
+/// @return A random initial value for the hash functions, obtained from the operating system when
+/// possible. Otherwise, the value is derived from the current time and the address of the stack,
+/// which is much easier to guess.
+[[nodiscard]] static inline uint32_t hash_random_seed(void) {
+    uint32_t seed;
+#ifdef HASH_HAS_GETENTROPY
+    if (!getentropy(&seed, sizeof(seed)))
+        return seed;
+#endif
+    struct timespec ts;
+    timespec_get(&ts, TIME_UTC);
+    uint64_t x = (uint64_t)ts.tv_sec * UINT64_C(1000000000) + (uint64_t)ts.tv_nsec;
+    seed = hash_fast_uint64(hash_init(), x);
+    return hash_fast_uint64(seed, (uintptr_t)&seed);
+}
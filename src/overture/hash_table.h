@@ -7,38 +7,131 @@
 #include <stdbool.h>
 #include <assert.h>
 
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#endif
+
 #include "primes.h"
+#include "bits.h"
+#include "hash.h"
 #include "mem.h"
 
 /// @file
 ///
 /// Low-level hash table data structure. When possible, prefer the use of the map or set data
 /// structures, as they provide more type safety.
+///
+/// By default, hash tables use linear probing over the array of hashes, with Robin Hood insertion:
+/// Elements in a run of occupied buckets are kept sorted by the bucket where their search starts,
+/// such that a lookup can stop as soon as it reaches an element that is closer to its own starting
+/// bucket than the searched element would be. Alternatively, the @ref HASH_TABLE_GROUPED flag
+/// makes the table probe groups of 7-bit control bytes (one byte per bucket) using SIMD
+/// instructions when available. In that mode, lookups only access the control bytes and the keys
+/// whose control byte matches, at the cost of one additional byte per bucket.
+///
+/// Capacities are prime numbers by default. The @ref HASH_TABLE_POW2 flag instead uses power-of-two
+/// capacities, where the bucket of a hash is selected with a multiplication and a shift (Fibonacci
+/// hashing) instead of a division, and where the capacity simply doubles when the table grows.
+///
+/// Growing a table normally rehashes all its elements at once. With the @ref HASH_TABLE_INCREMENTAL
+/// flag, the previous table is kept around instead, and every subsequent insertion or removal
+/// migrates a bounded number of its buckets into the new table, which bounds the latency of each
+/// operation. Lookups search both tables, but do not migrate any element, as they do not modify
+/// the table.
+///
+/// Each table has a seed, which is the initial value that maps and sets pass to their hash
+/// function. It is @ref hash_init by default, which makes hashes reproducible from one run to the
+/// next. The @ref HASH_TABLE_SEEDED flag instead picks a random seed when the table is created,
+/// which, combined with a keyed hash function such as @ref hash_sip_bytes, protects tables that
+/// hold untrusted keys against collision attacks.
+
+/// Hash table layout options.
+enum hash_table_flags {
+    HASH_TABLE_DEFAULT     = 0,     ///< Linear probing over the array of hashes.
+    HASH_TABLE_GROUPED     = 0x01,  ///< Group probing over an additional array of control bytes.
+    HASH_TABLE_POW2        = 0x02,  ///< Power-of-two capacities with Fibonacci hashing.
+    HASH_TABLE_INCREMENTAL = 0x04,  ///< Incremental migration of the elements when growing.
+    HASH_TABLE_SEEDED      = 0x08,  ///< Random seed for the hash function, chosen at creation.
+};
 
 /// Hash table. Can represent both a map or a set.
 struct hash_table {
-    size_t capacity;    ///< Capacity of the hash table, in number of elements.
-    uint32_t* hashes;   ///< Hashes of the keys, with one bit reserved for an occupancy flag.
-    char* keys;         ///< Hash table keys.
-    char* vals;         ///< Hash table values. May be `NULL`.
+    size_t capacity;                ///< Capacity of the hash table, in number of elements.
+    enum hash_table_flags flags;    ///< Layout options used when the table was created.
+    unsigned bucket_shift;          ///< Shift used to compute buckets, only used with @ref HASH_TABLE_POW2.
+    unsigned max_load_factor;       ///< Load factor (in percent) above which the table grows.
+    unsigned min_load_factor;       ///< Load factor (in percent) below which the table shrinks, or 0.
+    uint32_t seed;                  ///< Initial value of the hash function used with this table.
+    uint32_t* hashes;               ///< Hashes of the keys, with one bit reserved for an occupancy flag.
+    uint8_t* ctrl;                  ///< Control bytes, only used with @ref HASH_TABLE_GROUPED, or `NULL`.
+    size_t tombstone_count;         ///< Number of deleted control bytes.
+    char* keys;                     ///< Hash table keys.
+    char* vals;                     ///< Hash table values. May be `NULL`.
+    struct hash_table* old_table;   ///< Table being migrated, only used with @ref HASH_TABLE_INCREMENTAL, or `NULL`.
+    size_t migration_idx;           ///< Index of the next bucket to migrate in the old table.
 };
 
 /// @cond PRIVATE
 #define HASH_TABLE_OCCUPIED_FLAG UINT32_C(0x80000000)
 #define HASH_TABLE_MAX_LOAD_FACTOR 70 //%
+#define HASH_TABLE_MAX_LOAD_FACTOR_LIMIT 90 //%
+#define HASH_TABLE_GROUP_SIZE 16
+#define HASH_TABLE_CTRL_EMPTY UINT8_C(0x80)
+#define HASH_TABLE_CTRL_DELETED UINT8_C(0xFE)
+#define HASH_TABLE_MIGRATION_STEP 8
+#define HASH_TABLE_MIN_POW2_CAPACITY 8
+#define HASH_TABLE_FIBONACCI_FACTOR UINT64_C(11400714819323198485) // 2^64 / golden ratio
+
+static inline size_t hash_table_round_capacity(size_t capacity, enum hash_table_flags flags) {
+    if ((flags & HASH_TABLE_GROUPED) && capacity < HASH_TABLE_GROUP_SIZE)
+        capacity = HASH_TABLE_GROUP_SIZE;
+    if (!(flags & HASH_TABLE_POW2))
+        return next_prime(capacity);
+    size_t pow2 = HASH_TABLE_MIN_POW2_CAPACITY;
+    while (pow2 < capacity)
+        pow2 <<= 1;
+    return pow2;
+}
+
+static inline unsigned hash_table_compute_bucket_shift(size_t capacity) {
+    unsigned shift = 64;
+    for (; capacity > 1; capacity >>= 1)
+        shift--;
+    return shift;
+}
 /// @endcond
 
 /// Creates a hash table.
 /// @param key_size Size of a key (in bytes)
 /// @param val_size Size of a value (in bytes)
 /// @param init_capacity Initial capacity (in number of elements)
-[[nodiscard]] static inline struct hash_table hash_table_create(size_t key_size, size_t val_size, size_t init_capacity) {
+/// @param flags Layout options for the hash table.
+[[nodiscard]] static inline struct hash_table hash_table_create(
+    size_t key_size,
+    size_t val_size,
+    size_t init_capacity,
+    enum hash_table_flags flags)
+{
     assert(key_size > 0);
-    init_capacity = next_prime(init_capacity);
+    init_capacity = hash_table_round_capacity(init_capacity, flags);
+    uint8_t* ctrl = NULL;
+    if (flags & HASH_TABLE_GROUPED) {
+        // Groups are loaded at arbitrary bucket indices: The first bytes of the control array are
+        // mirrored after its end so that loads never need to wrap around.
+        ctrl = xmalloc(init_capacity + HASH_TABLE_GROUP_SIZE - 1);
+        memset(ctrl, HASH_TABLE_CTRL_EMPTY, init_capacity + HASH_TABLE_GROUP_SIZE - 1);
+    }
     char* vals = val_size > 0 ? xmalloc(val_size * init_capacity) : NULL;
     return (struct hash_table) {
         .capacity = init_capacity,
+        .flags = flags,
+        .bucket_shift = flags & HASH_TABLE_POW2 ? hash_table_compute_bucket_shift(init_capacity) : 0,
+        .max_load_factor = HASH_TABLE_MAX_LOAD_FACTOR,
+        .seed = flags & HASH_TABLE_SEEDED ? hash_random_seed() : hash_init(),
         .hashes = xcalloc(init_capacity, sizeof(uint32_t)),
+        .ctrl = ctrl,
         .keys = xmalloc(key_size * init_capacity),
         .vals = vals
     };
@@ -46,114 +139,563 @@ struct hash_table {
 
 /// Destroys the given hash table.
 static inline void hash_table_destroy(struct hash_table* hash_table) {
+    if (hash_table->old_table) {
+        hash_table_destroy(hash_table->old_table);
+        free(hash_table->old_table);
+    }
     free(hash_table->hashes);
+    free(hash_table->ctrl);
     free(hash_table->vals);
     free(hash_table->keys);
     memset(hash_table, 0, sizeof(struct hash_table));
 }
 
+/// Retrieves the bucket where the search for an element with the given hash starts.
+static inline size_t hash_table_first_bucket(const struct hash_table* hash_table, uint32_t hash) {
+    if (hash_table->flags & HASH_TABLE_POW2)
+        return (size_t)((hash * HASH_TABLE_FIBONACCI_FACTOR) >> hash_table->bucket_shift);
+    return mod_prime(hash, hash_table->capacity);
+}
+
 /// Retrieves the next hash table bucket after the given index.
 static inline size_t hash_table_next_bucket(const struct hash_table* hash_table, size_t bucket_idx) {
     return bucket_idx + 1 < hash_table->capacity ? bucket_idx + 1 : 0;
 }
 
+/// Retrieves the previous hash table bucket before the given index.
+static inline size_t hash_table_prev_bucket(const struct hash_table* hash_table, size_t bucket_idx) {
+    return bucket_idx > 0 ? bucket_idx - 1 : hash_table->capacity - 1;
+}
+
+/// @return The number of buckets between the given occupied bucket and the bucket where the
+/// search for its element starts.
+static inline size_t hash_table_probe_distance(const struct hash_table* hash_table, size_t bucket_idx) {
+    size_t first_idx = hash_table_first_bucket(hash_table, hash_table->hashes[bucket_idx]);
+    return bucket_idx >= first_idx ? bucket_idx - first_idx : bucket_idx + hash_table->capacity - first_idx;
+}
+
 /// @return `true` if the bucket at the given index is occupied, `false` otherwise.
 static inline bool hash_table_is_bucket_occupied(const struct hash_table* hash_table, size_t bucket_idx) {
     return (hash_table->hashes[bucket_idx] & HASH_TABLE_OCCUPIED_FLAG) != 0;
 }
 
+/// Whatever the load factor, a table needs rehashing before one more insertion could fill its last
+/// empty bucket, since lookups stop at the first empty bucket that they find. The number of elements
+/// can thus be the number before or after the insertion that triggers the check.
 /// @return `true` if the hash table needs rehashing, `false` otherwise.
 static inline bool hash_table_needs_rehash(const struct hash_table* hash_table, size_t elem_count) {
-    return elem_count * 100 >= hash_table->capacity * HASH_TABLE_MAX_LOAD_FACTOR;
+    size_t used_count = elem_count + hash_table->tombstone_count;
+    return
+        used_count * 100 >= hash_table->capacity * hash_table->max_load_factor ||
+        used_count + 2 >= hash_table->capacity;
+}
+
+/// @return `true` if the hash table is emptier than its minimum load factor allows, `false` otherwise.
+static inline bool hash_table_needs_shrink(const struct hash_table* hash_table, size_t elem_count) {
+    return elem_count * 100 < hash_table->capacity * hash_table->min_load_factor;
 }
 
-/// Clears the hash table, but keeps the allocated memory around.
+/// Clears the hash table, but keeps the allocated memory around (except for a table that is being
+/// migrated, which is destroyed).
 static inline void hash_table_clear(struct hash_table* hash_table) {
+    if (hash_table->old_table) {
+        hash_table_destroy(hash_table->old_table);
+        free(hash_table->old_table);
+        hash_table->old_table = NULL;
+        hash_table->migration_idx = 0;
+    }
     memset(hash_table->hashes, 0, sizeof(uint32_t) * hash_table->capacity);
+    if (hash_table->flags & HASH_TABLE_GROUPED)
+        memset(hash_table->ctrl, HASH_TABLE_CTRL_EMPTY, hash_table->capacity + HASH_TABLE_GROUP_SIZE - 1);
+    hash_table->tombstone_count = 0;
+}
+
+/// @cond PRIVATE
+static inline uint8_t hash_table_ctrl_byte(uint32_t hash) {
+    return (hash >> 24) & 0x7F;
+}
+
+static inline void hash_table_set_ctrl(struct hash_table* hash_table, size_t bucket_idx, uint8_t byte) {
+    hash_table->ctrl[bucket_idx] = byte;
+    if (bucket_idx < HASH_TABLE_GROUP_SIZE - 1)
+        hash_table->ctrl[hash_table->capacity + bucket_idx] = byte;
+}
+
+// Returns a mask where bit `i` is set if the `i`-th control byte of the group is equal to `byte`.
+static inline uint32_t hash_table_group_match(const uint8_t* group, uint8_t byte) {
+#if defined(__SSE2__)
+    __m128i ctrl = _mm_loadu_si128((const __m128i*)group);
+    return (uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(ctrl, _mm_set1_epi8((char)byte)));
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+    static const uint8_t bits[HASH_TABLE_GROUP_SIZE] = { 1, 2, 4, 8, 16, 32, 64, 128, 1, 2, 4, 8, 16, 32, 64, 128 };
+    uint8x16_t eq = vandq_u8(vceqq_u8(vld1q_u8(group), vdupq_n_u8(byte)), vld1q_u8(bits));
+    return vaddv_u8(vget_low_u8(eq)) | ((uint32_t)vaddv_u8(vget_high_u8(eq)) << 8);
+#else
+    uint32_t mask = 0;
+    for (size_t i = 0; i < HASH_TABLE_GROUP_SIZE; ++i)
+        mask |= (uint32_t)(group[i] == byte) << i;
+    return mask;
+#endif
+}
+
+// Returns a mask where bit `i` is set if the `i`-th control byte of the group is empty or deleted.
+static inline uint32_t hash_table_group_match_free(const uint8_t* group) {
+#if defined(__SSE2__)
+    return (uint32_t)_mm_movemask_epi8(_mm_loadu_si128((const __m128i*)group));
+#else
+    uint32_t mask = 0;
+    for (size_t i = 0; i < HASH_TABLE_GROUP_SIZE; ++i)
+        mask |= (uint32_t)(group[i] >> 7) << i;
+    return mask;
+#endif
+}
+
+static inline size_t hash_table_group_bucket(const struct hash_table* hash_table, size_t group_idx, uint32_t mask) {
+    size_t bucket_idx = group_idx + count_trailing_zeros(mask);
+    return bucket_idx < hash_table->capacity ? bucket_idx : bucket_idx - hash_table->capacity;
+}
+
+static inline size_t hash_table_next_group(const struct hash_table* hash_table, size_t group_idx) {
+    group_idx += HASH_TABLE_GROUP_SIZE;
+    return group_idx < hash_table->capacity ? group_idx : group_idx - hash_table->capacity;
+}
+
+// Finds the bucket where an element with the given hash should be placed, without looking for
+// existing elements with the same key. With linear probing, that bucket may be occupied by an
+// element that is closer to its starting bucket, which then has to be shifted.
+static inline size_t hash_table_find_free_bucket(const struct hash_table* hash_table, uint32_t hash) {
+    size_t idx = hash_table_first_bucket(hash_table, hash);
+    if (hash_table->flags & HASH_TABLE_GROUPED) {
+        uint32_t mask;
+        while (!(mask = hash_table_group_match_free(hash_table->ctrl + idx)))
+            idx = hash_table_next_group(hash_table, idx);
+        return hash_table_group_bucket(hash_table, idx, mask);
+    }
+    for (size_t dist = 0; hash_table_is_bucket_occupied(hash_table, idx); idx = hash_table_next_bucket(hash_table, idx), dist++) {
+        if (hash_table_probe_distance(hash_table, idx) < dist)
+            break;
+    }
+    return idx;
+}
+
+static inline void hash_table_move_bucket(
+    struct hash_table* hash_table,
+    size_t to_idx,
+    size_t from_idx,
+    size_t key_size,
+    size_t val_size)
+{
+    hash_table->hashes[to_idx] = hash_table->hashes[from_idx];
+    memcpy(hash_table->keys + to_idx * key_size, hash_table->keys + from_idx * key_size, key_size);
+    if (val_size != 0)
+        memcpy(hash_table->vals + to_idx * val_size, hash_table->vals + from_idx * val_size, val_size);
+}
+
+// Shifts the run of elements that starts at the given bucket by one bucket towards its end, so
+// that a new element can be placed there without breaking the Robin Hood ordering.
+static inline void hash_table_shift_run(
+    struct hash_table* hash_table,
+    size_t bucket_idx,
+    size_t key_size,
+    size_t val_size)
+{
+    size_t last_idx = bucket_idx;
+    while (hash_table_is_bucket_occupied(hash_table, last_idx))
+        last_idx = hash_table_next_bucket(hash_table, last_idx);
+    while (last_idx != bucket_idx) {
+        size_t prev_idx = hash_table_prev_bucket(hash_table, last_idx);
+        hash_table_move_bucket(hash_table, last_idx, prev_idx, key_size, val_size);
+        last_idx = prev_idx;
+    }
+}
+
+static inline void hash_table_place(
+    struct hash_table* hash_table,
+    size_t bucket_idx,
+    const void* key,
+    const void* val,
+    size_t key_size,
+    size_t val_size,
+    uint32_t hash)
+{
+    if (hash_table->flags & HASH_TABLE_GROUPED) {
+        if (hash_table->ctrl[bucket_idx] == HASH_TABLE_CTRL_DELETED)
+            hash_table->tombstone_count--;
+        hash_table_set_ctrl(hash_table, bucket_idx, hash_table_ctrl_byte(hash));
+    } else if (hash_table_is_bucket_occupied(hash_table, bucket_idx)) {
+        hash_table_shift_run(hash_table, bucket_idx, key_size, val_size);
+    }
+    hash_table->hashes[bucket_idx] = hash;
+    memcpy(hash_table->keys + bucket_idx * key_size, key, key_size);
+    if (val_size != 0 && val)
+        memcpy(hash_table->vals + bucket_idx * val_size, val, val_size);
+}
+/// @endcond
+
+/// @cond PRIVATE
+static inline bool hash_table_find_grouped(
+    const struct hash_table* hash_table,
+    size_t* found_idx,
+    const void* key,
+    size_t key_size,
+    uint32_t hash,
+    bool (*is_equal) (const void*, const void*))
+{
+    uint8_t byte = hash_table_ctrl_byte(hash);
+    size_t idx = hash_table_first_bucket(hash_table, hash);
+    while (true) {
+        const uint8_t* group = hash_table->ctrl + idx;
+        for (uint32_t mask = hash_table_group_match(group, byte); mask; mask &= mask - 1) {
+            size_t bucket_idx = hash_table_group_bucket(hash_table, idx, mask);
+            if (is_equal(hash_table->keys + bucket_idx * key_size, key)) {
+                *found_idx = bucket_idx;
+                return true;
+            }
+        }
+        if (hash_table_group_match(group, HASH_TABLE_CTRL_EMPTY))
+            return false;
+        idx = hash_table_next_group(hash_table, idx);
+    }
+}
+
+// Finds an element in the given table only, ignoring any table that is still being migrated.
+static inline bool hash_table_find_bucket(
+    const struct hash_table* hash_table,
+    size_t* found_idx,
+    const void* key,
+    size_t key_size,
+    uint32_t hash,
+    bool (*is_equal) (const void*, const void*))
+{
+    if (hash_table->flags & HASH_TABLE_GROUPED)
+        return hash_table_find_grouped(hash_table, found_idx, key, key_size, hash, is_equal);
+
+    size_t idx = hash_table_first_bucket(hash_table, hash);
+    for (size_t dist = 0; hash_table_is_bucket_occupied(hash_table, idx); idx = hash_table_next_bucket(hash_table, idx), dist++) {
+        if (hash_table->hashes[idx] == hash) {
+            if (is_equal(hash_table->keys + idx * key_size, key)) {
+                *found_idx = idx;
+                return true;
+            }
+        } else if (hash_table_probe_distance(hash_table, idx) < dist) {
+            break;
+        }
+    }
+    return false;
+}
+
+// Removes the element at the given index. The control byte can only be marked as empty if no group
+// containing it has ever been full, since a lookup might otherwise have skipped past it.
+static inline void hash_table_remove_grouped(struct hash_table* hash_table, size_t idx) {
+    size_t prev_idx = idx >= HASH_TABLE_GROUP_SIZE
+        ? idx - HASH_TABLE_GROUP_SIZE
+        : idx + hash_table->capacity - HASH_TABLE_GROUP_SIZE;
+    uint32_t empty_before = hash_table_group_match(hash_table->ctrl + prev_idx, HASH_TABLE_CTRL_EMPTY);
+    uint32_t empty_after  = hash_table_group_match(hash_table->ctrl + idx, HASH_TABLE_CTRL_EMPTY);
+    bool was_never_full =
+        empty_before && empty_after &&
+        count_trailing_zeros(empty_after) + count_leading_zeros(empty_before << 16) < HASH_TABLE_GROUP_SIZE;
+    if (!was_never_full)
+        hash_table->tombstone_count++;
+    hash_table_set_ctrl(hash_table, idx, was_never_full ? HASH_TABLE_CTRL_EMPTY : HASH_TABLE_CTRL_DELETED);
+    hash_table->hashes[idx] = 0;
+}
+
+// Removes the element at the given index of the given table only.
+static inline void hash_table_remove_bucket(
+    struct hash_table* hash_table,
+    size_t idx,
+    size_t key_size,
+    size_t val_size)
+{
+    if (hash_table->flags & HASH_TABLE_GROUPED) {
+        hash_table_remove_grouped(hash_table, idx);
+        return;
+    }
+
+    // Backward-shift deletion: Move the following elements of the run one bucket closer to their
+    // starting bucket, until an element that is already in its starting bucket is found.
+    size_t next_idx = hash_table_next_bucket(hash_table, idx);
+    while (hash_table_is_bucket_occupied(hash_table, next_idx) && hash_table_probe_distance(hash_table, next_idx) > 0) {
+        hash_table_move_bucket(hash_table, idx, next_idx, key_size, val_size);
+        idx = next_idx;
+        next_idx = hash_table_next_bucket(hash_table, next_idx);
+    }
+    hash_table->hashes[idx] = 0;
+}
+
+// Moves the elements of the given number of buckets from the table being migrated into the new
+// one. Migrated elements are removed from the old table, which therefore stays a valid hash table
+// that only contains the elements that have not been migrated yet.
+static inline void hash_table_migrate(
+    struct hash_table* hash_table,
+    size_t key_size,
+    size_t val_size,
+    size_t bucket_count)
+{
+    struct hash_table* old_table = hash_table->old_table;
+    size_t end_idx = old_table->capacity - hash_table->migration_idx > bucket_count
+        ? hash_table->migration_idx + bucket_count
+        : old_table->capacity;
+    for (size_t i = hash_table->migration_idx; i < end_idx; ++i) {
+        while (hash_table_is_bucket_occupied(old_table, i)) {
+            uint32_t hash = old_table->hashes[i];
+            hash_table_place(
+                hash_table, hash_table_find_free_bucket(hash_table, hash),
+                old_table->keys + i * key_size,
+                val_size != 0 ? old_table->vals + i * val_size : NULL,
+                key_size, val_size, hash);
+            hash_table_remove_bucket(old_table, i, key_size, val_size);
+        }
+    }
+    hash_table->migration_idx = end_idx;
+    if (end_idx == old_table->capacity) {
+        hash_table_destroy(old_table);
+        free(old_table);
+        hash_table->old_table = NULL;
+        hash_table->migration_idx = 0;
+    }
+}
+
+static inline void hash_table_finish_migration(struct hash_table* hash_table, size_t key_size, size_t val_size) {
+    if (hash_table->old_table)
+        hash_table_migrate(hash_table, key_size, val_size, hash_table->old_table->capacity);
+}
+/// @endcond
+
+/// @return A pointer to the key stored at the given index, as returned by @ref hash_table_find.
+[[nodiscard]] static inline void* hash_table_key(const struct hash_table* hash_table, size_t idx, size_t key_size) {
+    if (idx >= hash_table->capacity)
+        return hash_table->old_table->keys + (idx - hash_table->capacity) * key_size;
+    return hash_table->keys + idx * key_size;
+}
+
+/// @return A pointer to the value stored at the given index, as returned by @ref hash_table_find.
+[[nodiscard]] static inline void* hash_table_val(const struct hash_table* hash_table, size_t idx, size_t val_size) {
+    if (idx >= hash_table->capacity)
+        return hash_table->old_table->vals + (idx - hash_table->capacity) * val_size;
+    return hash_table->vals + idx * val_size;
 }
 
 /// Rehashes the elements into a hash table with the given capacity. The capacity must be large
-/// enough to hold all the elements of the hash table.
+/// enough to hold all the elements of the hash table. Any migration in progress is completed first.
 static inline void hash_table_rehash(
     struct hash_table* hash_table,
     size_t key_size,
     size_t val_size,
     size_t capacity)
 {
-    struct hash_table copy = hash_table_create(key_size, val_size, capacity);
+    hash_table_finish_migration(hash_table, key_size, val_size);
+    struct hash_table copy = hash_table_create(key_size, val_size, capacity, hash_table->flags);
+    copy.max_load_factor = hash_table->max_load_factor;
+    copy.min_load_factor = hash_table->min_load_factor;
+    copy.seed = hash_table->seed;
     for (size_t i = 0; i < hash_table->capacity; ++i) {
         if (!hash_table_is_bucket_occupied(hash_table, i))
             continue;
         uint32_t hash = hash_table->hashes[i];
-        size_t idx = mod_prime(hash, copy.capacity);
-        while (hash_table_is_bucket_occupied(&copy, idx))
-            idx = hash_table_next_bucket(&copy, idx);
-        copy.hashes[idx] = hash;
-        memcpy(copy.keys + idx * key_size, hash_table->keys + i * key_size, key_size);
-        if (val_size != 0)
-            memcpy(copy.vals + idx * val_size, hash_table->vals + i * val_size, val_size);
+        hash_table_place(
+            &copy, hash_table_find_free_bucket(&copy, hash),
+            hash_table->keys + i * key_size,
+            val_size != 0 ? hash_table->vals + i * val_size : NULL,
+            key_size, val_size, hash);
     }
     hash_table_destroy(hash_table);
     *hash_table = copy;
 }
 
-/// Rehashes the given hash table into a new one with larger capacity computed automatically.
+/// Rehashes the given hash table into a new one with larger capacity computed automatically. If
+/// the table is mostly filled with deleted elements, it is instead rehashed with the same capacity.
+/// With @ref HASH_TABLE_INCREMENTAL, this only allocates the new table, and the elements are then
+/// migrated progressively by the following insertions and removals.
 static inline void hash_table_grow(
     struct hash_table* hash_table,
     size_t key_size,
     size_t val_size)
 {
-    size_t next_capacity = hash_table->capacity < MAX_PRIME
-        ? next_prime(hash_table->capacity + 1)
-        : hash_table->capacity + (hash_table->capacity >> 1);
+    size_t next_capacity = hash_table->capacity * 2;
+    if (!(hash_table->flags & HASH_TABLE_POW2)) {
+        next_capacity = hash_table->capacity < MAX_PRIME
+            ? next_prime(hash_table->capacity + 1)
+            : hash_table->capacity + (hash_table->capacity >> 1);
+    }
+    if (hash_table->tombstone_count * 200 >= hash_table->capacity * hash_table->max_load_factor)
+        next_capacity = hash_table->capacity;
+
+    if (hash_table->flags & HASH_TABLE_INCREMENTAL) {
+        hash_table_finish_migration(hash_table, key_size, val_size);
+        struct hash_table* old_table = xmalloc(sizeof(struct hash_table));
+        *old_table = *hash_table;
+        *hash_table = hash_table_create(key_size, val_size, next_capacity, old_table->flags);
+        hash_table->max_load_factor = old_table->max_load_factor;
+        hash_table->min_load_factor = old_table->min_load_factor;
+        hash_table->seed = old_table->seed;
+        hash_table->old_table = old_table;
+        return;
+    }
     hash_table_rehash(hash_table, key_size, val_size, next_capacity);
 }
 
-/// Inserts an element into a hash table.
-/// @return `true` if the element could not be inserted because it already existed, `false` otherwise.
+/// Makes sure that the given number of elements can be held in the hash table without growing it,
+/// by rehashing it into a larger table if necessary.
+static inline void hash_table_reserve(
+    struct hash_table* hash_table,
+    size_t key_size,
+    size_t val_size,
+    size_t elem_count)
+{
+    if (elem_count * 100 < hash_table->capacity * hash_table->max_load_factor)
+        return;
+    hash_table_rehash(hash_table, key_size, val_size, elem_count * 100 / hash_table->max_load_factor + 1);
+}
+
+/// Rehashes the hash table into the smallest table that can hold the given number of elements at
+/// the given load factor (in percent), if that is smaller than the current table.
+static inline void hash_table_shrink(
+    struct hash_table* hash_table,
+    size_t key_size,
+    size_t val_size,
+    size_t elem_count,
+    unsigned load_factor)
+{
+    assert(load_factor > 0 && load_factor <= hash_table->max_load_factor);
+    size_t capacity = hash_table_round_capacity(elem_count * 100 / load_factor + 1, hash_table->flags);
+    if (capacity < hash_table->capacity)
+        hash_table_rehash(hash_table, key_size, val_size, capacity);
+}
+
+/// Sets the load factors (in percent) of a hash table. The table grows when it is filled above the
+/// maximum load factor, and shrinks on removal when it is filled below the minimum load factor. A
+/// minimum load factor of 0 disables shrinking, which is the default. The minimum must be less than
+/// half the maximum, so that a table does not shrink again right after growing, or the opposite.
+/// The maximum cannot exceed 90, since probe sequences get very long as the table fills up.
+static inline void hash_table_set_load_factors(
+    struct hash_table* hash_table,
+    unsigned min_load_factor,
+    unsigned max_load_factor)
+{
+    assert(max_load_factor > 0 && max_load_factor <= HASH_TABLE_MAX_LOAD_FACTOR_LIMIT);
+    assert(min_load_factor * 2 < max_load_factor);
+    hash_table->min_load_factor = min_load_factor;
+    hash_table->max_load_factor = max_load_factor;
+}
+
+/// Prefetches the memory accessed first when searching for a key with the given hash. Issuing
+/// prefetches for several independent keys before searching for them hides the latency of the
+/// corresponding cache misses.
+static inline void hash_table_prefetch(const struct hash_table* hash_table, size_t key_size, uint32_t hash) {
+    size_t idx = hash_table_first_bucket(hash_table, hash | HASH_TABLE_OCCUPIED_FLAG);
+    if (hash_table->flags & HASH_TABLE_GROUPED)
+        __builtin_prefetch(hash_table->ctrl + idx);
+    else
+        __builtin_prefetch(hash_table->hashes + idx);
+    __builtin_prefetch(hash_table->keys + idx * key_size);
+}
+
+/// Finds an element in a hash table.
+/// @param found_idx On success, contains the index of the element, which can be turned into a
+///   pointer to its key or value with @ref hash_table_key and @ref hash_table_val.
+/// @return `true` if the element was found, `false` otherwise.
+static inline bool hash_table_find(
+    const struct hash_table* hash_table,
+    size_t* found_idx,
+    const void* key,
+    size_t key_size,
+    uint32_t hash,
+    bool (*is_equal) (const void*, const void*))
+{
+    hash |= HASH_TABLE_OCCUPIED_FLAG;
+    if (hash_table_find_bucket(hash_table, found_idx, key, key_size, hash, is_equal))
+        return true;
+    if (hash_table->old_table && hash_table_find_bucket(hash_table->old_table, found_idx, key, key_size, hash, is_equal)) {
+        *found_idx += hash_table->capacity;
+        return true;
+    }
+    return false;
+}
+
+/// Finds an element in a hash table, or inserts it if it does not exist, using a single probe
+/// sequence. The value of an inserted element is left uninitialized.
+/// @param found_idx Contains the index of the element that was found or inserted, which can be
+///   turned into a pointer to its key or value with @ref hash_table_key and @ref hash_table_val.
+/// @return `true` if the element was inserted, `false` if it already existed.
 /// Note that this code does not rehash the hash table, it is the responsibility of the caller to
 /// use @ref hash_table_needs_rehash and @ref hash_table_grow as needed.
-static inline bool hash_table_insert(
+static inline bool hash_table_find_or_insert(
     struct hash_table* hash_table,
+    size_t* found_idx,
     const void* key,
-    const void* val,
     size_t key_size,
     size_t val_size,
     uint32_t hash,
     bool (*is_equal) (const void*, const void*))
 {
     hash |= HASH_TABLE_OCCUPIED_FLAG;
-    size_t idx = mod_prime(hash, hash_table->capacity);
-    for (; hash_table_is_bucket_occupied(hash_table, idx); idx = hash_table_next_bucket(hash_table, idx)) {
-        if (hash_table->hashes[idx] == hash && is_equal(hash_table->keys + idx * key_size, key))
+    if (hash_table->old_table) {
+        hash_table_migrate(hash_table, key_size, val_size, HASH_TABLE_MIGRATION_STEP);
+        if (hash_table->old_table && hash_table_find_bucket(hash_table->old_table, found_idx, key, key_size, hash, is_equal)) {
+            *found_idx += hash_table->capacity;
             return false;
+        }
     }
-    hash_table->hashes[idx] = hash;
-    memcpy(hash_table->keys + idx * key_size, key, key_size);
-    if (val_size != 0)
-        memcpy(hash_table->vals + idx * val_size, val, val_size);
+
+    if (hash_table->flags & HASH_TABLE_GROUPED) {
+        if (hash_table_find_grouped(hash_table, found_idx, key, key_size, hash, is_equal))
+            return false;
+        *found_idx = hash_table_find_free_bucket(hash_table, hash);
+        hash_table_place(hash_table, *found_idx, key, NULL, key_size, val_size, hash);
+        return true;
+    }
+
+    size_t idx = hash_table_first_bucket(hash_table, hash);
+    for (size_t dist = 0; hash_table_is_bucket_occupied(hash_table, idx); idx = hash_table_next_bucket(hash_table, idx), dist++) {
+        if (hash_table->hashes[idx] == hash) {
+            if (is_equal(hash_table->keys + idx * key_size, key)) {
+                *found_idx = idx;
+                return false;
+            }
+        } else if (hash_table_probe_distance(hash_table, idx) < dist) {
+            break;
+        }
+    }
+    hash_table_place(hash_table, idx, key, NULL, key_size, val_size, hash);
+    *found_idx = idx;
     return true;
 }
 
-/// Finds an element in a hash table.
-/// @return `true` if the element was found, `false` otherwise.
-static inline bool hash_table_find(
-    const struct hash_table* hash_table,
-    size_t* found_idx,
+/// Inserts an element into a hash table.
+/// @return `true` if the element was inserted, `false` if it already existed.
+/// Note that this code does not rehash the hash table, it is the responsibility of the caller to
+/// use @ref hash_table_needs_rehash and @ref hash_table_grow as needed.
+static inline bool hash_table_insert(
+    struct hash_table* hash_table,
     const void* key,
+    const void* val,
     size_t key_size,
+    size_t val_size,
     uint32_t hash,
     bool (*is_equal) (const void*, const void*))
 {
-    hash |= HASH_TABLE_OCCUPIED_FLAG;
-    size_t idx = mod_prime(hash, hash_table->capacity);
-    for (; hash_table_is_bucket_occupied(hash_table, idx); idx = hash_table_next_bucket(hash_table, idx)) {
-        if (hash_table->hashes[idx] == hash && is_equal(hash_table->keys + idx * key_size, key)) {
-            *found_idx = idx;
-            return true;
-        }
-    }
-    return false;
+    size_t idx;
+    if (!hash_table_find_or_insert(hash_table, &idx, key, key_size, val_size, hash, is_equal))
+        return false;
+    if (val_size != 0)
+        memcpy(hash_table->vals + idx * val_size, val, val_size);
+    return true;
+}
+
+/// Removes the element at the given index, as returned by @ref hash_table_find. Unlike
+/// @ref hash_table_remove, this does not migrate any element (see @ref HASH_TABLE_INCREMENTAL).
+static inline void hash_table_remove_at(
+    struct hash_table* hash_table,
+    size_t idx,
+    size_t key_size,
+    size_t val_size)
+{
+    if (idx >= hash_table->capacity)
+        hash_table_remove_bucket(hash_table->old_table, idx - hash_table->capacity, key_size, val_size);
+    else
+        hash_table_remove_bucket(hash_table, idx, key_size, val_size);
 }
 
 /// Removes an element from a hash table.
@@ -166,26 +708,138 @@ static inline bool hash_table_remove(
     uint32_t hash,
     bool (*is_equal) (const void*, const void*))
 {
-    hash |= HASH_TABLE_OCCUPIED_FLAG;
+    if (hash_table->old_table)
+        hash_table_migrate(hash_table, key_size, val_size, HASH_TABLE_MIGRATION_STEP);
+
     size_t idx;
     if (!hash_table_find(hash_table, &idx, key, key_size, hash, is_equal))
         return false;
+    hash_table_remove_at(hash_table, idx, key_size, val_size);
+    return true;
+}
 
-    size_t next_idx = hash_table_next_bucket(hash_table, idx);
-    while (hash_table_is_bucket_occupied(hash_table, next_idx)) {
-        uint32_t next_hash = hash_table->hashes[next_idx];
-        size_t ideal_next_idx = mod_prime(next_hash, hash_table->capacity);
-        if (
-            (next_idx > idx && (ideal_next_idx <= idx || ideal_next_idx > next_idx)) ||
-            (next_idx < idx && (ideal_next_idx <= idx && ideal_next_idx > next_idx)))
-        {
-            xmemcpy(hash_table->keys + idx * key_size, hash_table->keys + next_idx * key_size, key_size);
-            xmemcpy(hash_table->vals + idx * val_size, hash_table->vals + next_idx * val_size, val_size);
-            hash_table->hashes[idx] = hash_table->hashes[next_idx];
-            idx = next_idx;
-        }
-        next_idx = hash_table_next_bucket(hash_table, next_idx);
+/// Statistics about the distribution of elements in a hash table.
+struct hash_table_stats {
+    size_t elem_count;          ///< Number of elements in the hash table.
+    size_t capacity;            ///< Capacity of the hash table, in number of elements.
+    size_t tombstone_count;     ///< Number of deleted control bytes (see @ref HASH_TABLE_GROUPED).
+    size_t max_probe_length;    ///< Maximum number of buckets visited to find an element.
+    double mean_probe_length;   ///< Average number of buckets visited to find an element.
+    double load_factor;         ///< Ratio between the number of elements and the capacity.
+};
+
+/// Computes statistics about the given hash table. This visits every bucket of the table, and is
+/// intended to help tuning the capacity of hash tables. Elements that are still in a table being
+/// migrated (see @ref HASH_TABLE_INCREMENTAL) are not taken into account.
+[[nodiscard]] static inline struct hash_table_stats hash_table_stats(const struct hash_table* hash_table) {
+    struct hash_table_stats stats = {
+        .capacity = hash_table->capacity,
+        .tombstone_count = hash_table->tombstone_count
+    };
+    size_t total_probe_length = 0;
+    for (size_t i = 0; i < hash_table->capacity; ++i) {
+        if (!hash_table_is_bucket_occupied(hash_table, i))
+            continue;
+        size_t probe_length = hash_table_probe_distance(hash_table, i) + 1;
+        stats.max_probe_length = stats.max_probe_length < probe_length ? probe_length : stats.max_probe_length;
+        total_probe_length += probe_length;
+        stats.elem_count++;
     }
-    hash_table->hashes[idx] = 0;
-    return true;
+    if (stats.elem_count > 0)
+        stats.mean_probe_length = (double)total_probe_length / (double)stats.elem_count;
+    if (stats.capacity > 0)
+        stats.load_factor = (double)stats.elem_count / (double)stats.capacity;
+    return stats;
 }
+
+/// @cond PRIVATE
+// Generates lookup, insertion, and removal functions specialized for a key type whose values can be
+// compared bitwise. The probe loops are the same as for generic keys, but compare keys with a
+// `memcmp` of constant size instead of calling a comparison function through a pointer. When an
+// element is not found in a table without groups, the lookup leaves the index of the bucket where
+// it should be inserted in `found_idx`, which saves a second probe on insertion.
+#define HASH_TABLE_TRIVIAL_IMPL(name, key_ty, val_size) \
+    static inline bool name##_table_find_bucket(const struct hash_table* hash_table, size_t* found_idx, key_ty const* key, uint32_t hash) { \
+        key_ty const* keys = (key_ty const*)hash_table->keys; \
+        size_t idx = hash_table_first_bucket(hash_table, hash); \
+        if (hash_table->flags & HASH_TABLE_GROUPED) { \
+            uint8_t byte = hash_table_ctrl_byte(hash); \
+            while (true) { \
+                const uint8_t* group = hash_table->ctrl + idx; \
+                for (uint32_t mask = hash_table_group_match(group, byte); mask; mask &= mask - 1) { \
+                    size_t bucket_idx = hash_table_group_bucket(hash_table, idx, mask); \
+                    if (!memcmp(&keys[bucket_idx], key, sizeof(key_ty))) { \
+                        *found_idx = bucket_idx; \
+                        return true; \
+                    } \
+                } \
+                if (hash_table_group_match(group, HASH_TABLE_CTRL_EMPTY)) \
+                    return false; \
+                idx = hash_table_next_group(hash_table, idx); \
+            } \
+        } \
+        for (size_t dist = 0; hash_table_is_bucket_occupied(hash_table, idx); idx = hash_table_next_bucket(hash_table, idx), dist++) { \
+            if (hash_table->hashes[idx] == hash) { \
+                if (!memcmp(&keys[idx], key, sizeof(key_ty))) { \
+                    *found_idx = idx; \
+                    return true; \
+                } \
+            } else if (hash_table_probe_distance(hash_table, idx) < dist) { \
+                break; \
+            } \
+        } \
+        *found_idx = idx; \
+        return false; \
+    } \
+    static inline bool name##_table_find(const struct hash_table* hash_table, size_t* found_idx, key_ty const* key, uint32_t hash) { \
+        hash |= HASH_TABLE_OCCUPIED_FLAG; \
+        if (name##_table_find_bucket(hash_table, found_idx, key, hash)) \
+            return true; \
+        if (hash_table->old_table && name##_table_find_bucket(hash_table->old_table, found_idx, key, hash)) { \
+            *found_idx += hash_table->capacity; \
+            return true; \
+        } \
+        return false; \
+    } \
+    static inline bool name##_table_find_or_insert(struct hash_table* hash_table, size_t* found_idx, key_ty const* key, uint32_t hash) { \
+        hash |= HASH_TABLE_OCCUPIED_FLAG; \
+        if (hash_table->old_table) { \
+            hash_table_migrate(hash_table, sizeof(key_ty), val_size, HASH_TABLE_MIGRATION_STEP); \
+            if (hash_table->old_table && name##_table_find_bucket(hash_table->old_table, found_idx, key, hash)) { \
+                *found_idx += hash_table->capacity; \
+                return false; \
+            } \
+        } \
+        if (name##_table_find_bucket(hash_table, found_idx, key, hash)) \
+            return false; \
+        if (hash_table->flags & HASH_TABLE_GROUPED) \
+            *found_idx = hash_table_find_free_bucket(hash_table, hash); \
+        hash_table_place(hash_table, *found_idx, key, NULL, sizeof(key_ty), val_size, hash); \
+        return true; \
+    } \
+    static inline bool name##_table_remove(struct hash_table* hash_table, key_ty const* key, uint32_t hash) { \
+        if (hash_table->old_table) \
+            hash_table_migrate(hash_table, sizeof(key_ty), val_size, HASH_TABLE_MIGRATION_STEP); \
+        size_t idx; \
+        if (!name##_table_find(hash_table, &idx, key, hash)) \
+            return false; \
+        hash_table_remove_at(hash_table, idx, sizeof(key_ty), val_size); \
+        return true; \
+    }
+
+// Generates the same functions as @ref HASH_TABLE_TRIVIAL_IMPL, for keys compared with the given
+// comparison function.
+#define HASH_TABLE_GENERIC_IMPL(name, key_ty, val_size, is_equal) \
+    static inline bool name##_is_equal_wrapper(const void* left, const void* right) { \
+        return is_equal((key_ty const*)left, (key_ty const*)right); \
+    } \
+    static inline bool name##_table_find(const struct hash_table* hash_table, size_t* found_idx, key_ty const* key, uint32_t hash) { \
+        return hash_table_find(hash_table, found_idx, key, sizeof(key_ty), hash, name##_is_equal_wrapper); \
+    } \
+    static inline bool name##_table_find_or_insert(struct hash_table* hash_table, size_t* found_idx, key_ty const* key, uint32_t hash) { \
+        return hash_table_find_or_insert(hash_table, found_idx, key, sizeof(key_ty), val_size, hash, name##_is_equal_wrapper); \
+    } \
+    static inline bool name##_table_remove(struct hash_table* hash_table, key_ty const* key, uint32_t hash) { \
+        return hash_table_remove(hash_table, key, sizeof(key_ty), val_size, hash, name##_is_equal_wrapper); \
+    }
+/// @endcond
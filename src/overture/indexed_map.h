@@ -0,0 +1,150 @@
+#pragma once
+
+#include "hash_table.h"
+#include "visibility.h"
+#include "hash.h"
+#include "vec.h"
+
+#include <stdint.h>
+#include <string.h>
+#include <assert.h>
+
+/// @file
+///
+/// Hash map data structure where keys and values are stored in dense vectors, in insertion order.
+/// The hash table only stores 32-bit indices into these vectors, which makes it smaller than the
+/// hash table of a regular map when keys or values are large, and makes iteration as fast as
+/// iterating over a vector. Removing an element moves the last element of the vectors into the
+/// place of the removed one, so that the vectors stay dense: Insertion order is preserved as long
+/// as no element is removed.
+/// @see hash_table, map.h.
+
+/// @cond PRIVATE
+#define INDEXED_MAP_DEFAULT_CAPACITY 4
+#define INDEXED_MAP_PREFIX indexed_map_very_long_prefix_
+/// @endcond
+
+/// Iterates over the keys and values of an indexed map, in insertion order.
+/// @param key_ty Type of the keys in the map.
+/// @param key Name of the variable holding a pointer to the current key.
+/// @param val_ty Type of the values in the map.
+/// @param val Name of the variable holding a pointer to the current value.
+/// @param map Expression evaluating to an indexed map.
+#define INDEXED_MAP_FOREACH(key_ty, key, val_ty, val, map) \
+    for (size_t INDEXED_MAP_PREFIX##i = 0; INDEXED_MAP_PREFIX##i < (map).keys.elem_count; ++INDEXED_MAP_PREFIX##i) \
+        for (bool INDEXED_MAP_PREFIX##once = true; INDEXED_MAP_PREFIX##once; INDEXED_MAP_PREFIX##once = false) \
+            for (key_ty const* key = &(map).keys.elems[INDEXED_MAP_PREFIX##i]; INDEXED_MAP_PREFIX##once; INDEXED_MAP_PREFIX##once = false) \
+                for (val_ty* val = &(map).vals.elems[INDEXED_MAP_PREFIX##i]; INDEXED_MAP_PREFIX##once; INDEXED_MAP_PREFIX##once = false)
+
+/// Declares and implements an indexed hash map.
+/// @param name Name of the structure representing the hash map.
+/// @param key_ty Type of the keys in the hash map.
+/// @param val_ty Type of the values in the hash map.
+/// @param hash Hash function with signature `uint32 (uint32_t, const key_ty*)`
+/// @param is_equal Comparison function with signature `bool (const key_ty*, const key_ty*)`.
+/// @param vis Visibility of the implementation.
+/// @see VISIBILITY, INDEXED_MAP_DECL, INDEXED_MAP_IMPL.
+#define INDEXED_MAP_DEFINE(name, key_ty, val_ty, hash, is_equal, vis) \
+    INDEXED_MAP_DECL(name, key_ty, val_ty, vis) \
+    INDEXED_MAP_IMPL(name, key_ty, val_ty, hash, is_equal, vis)
+
+/// Declares an indexed hash map. Typically used in header files.
+/// @see INDEXED_MAP_DEFINE.
+#define INDEXED_MAP_DECL(name, key_ty, val_ty, vis) \
+    VEC_DECL(name##_key_vec, key_ty, vis) \
+    VEC_DECL(name##_val_vec, val_ty, vis) \
+    struct name { \
+        struct hash_table hash_table; \
+        struct name##_key_vec keys; \
+        struct name##_val_vec vals; \
+    }; \
+    [[nodiscard]] VISIBILITY(vis) struct name name##_create_with_capacity(size_t); \
+    [[nodiscard]] VISIBILITY(vis) struct name name##_create(void); \
+    VISIBILITY(vis) void name##_destroy(struct name*); \
+    VISIBILITY(vis) void name##_clear(struct name*); \
+    VISIBILITY(vis) bool name##_insert(struct name*, key_ty const*, val_ty const*); \
+    [[nodiscard]] VISIBILITY(vis) bool name##_is_empty(const struct name*); \
+    VISIBILITY(vis) val_ty const* name##_find(const struct name*, key_ty const*); \
+    VISIBILITY(vis) bool name##_remove(struct name*, key_ty const*);
+
+/// Implements an indexed hash map. Typically used in source files.
+/// @see INDEXED_MAP_DEFINE.
+#define INDEXED_MAP_IMPL(name, key_ty, val_ty, hash, is_equal, vis) \
+    VEC_IMPL(name##_key_vec, key_ty, vis) \
+    VEC_IMPL(name##_val_vec, val_ty, vis) \
+    /* The index must be the first member, since it is what the hash table copies on insertion. */ \
+    struct name##_lookup { \
+        uint32_t idx; \
+        key_ty const* key; \
+        key_ty const* keys; \
+    }; \
+    static inline bool name##_is_equal_wrapper(const void* left, const void* right) { \
+        const struct name##_lookup* lookup = right; \
+        return is_equal(&lookup->keys[*(const uint32_t*)left], lookup->key); \
+    } \
+    static inline bool name##_is_same_idx(const void* left, const void* right) { \
+        return *(const uint32_t*)left == ((const struct name##_lookup*)right)->idx; \
+    } \
+    VISIBILITY(vis) struct name name##_create_with_capacity(size_t capacity) { \
+        return (struct name) { \
+            .hash_table = hash_table_create(sizeof(uint32_t), 0, capacity, HASH_TABLE_DEFAULT), \
+            .keys = name##_key_vec_create_with_capacity(capacity), \
+            .vals = name##_val_vec_create_with_capacity(capacity) \
+        }; \
+    } \
+    VISIBILITY(vis) struct name name##_create(void) { \
+        return name##_create_with_capacity(INDEXED_MAP_DEFAULT_CAPACITY); \
+    } \
+    VISIBILITY(vis) void name##_destroy(struct name* map) { \
+        hash_table_destroy(&map->hash_table); \
+        name##_key_vec_destroy(&map->keys); \
+        name##_val_vec_destroy(&map->vals); \
+    } \
+    VISIBILITY(vis) void name##_clear(struct name* map) { \
+        hash_table_clear(&map->hash_table); \
+        name##_key_vec_clear(&map->keys); \
+        name##_val_vec_clear(&map->vals); \
+    } \
+    VISIBILITY(vis) bool name##_insert(struct name* map, key_ty const* key, val_ty const* val) { \
+        assert(map->keys.elem_count < UINT32_MAX); \
+        struct name##_lookup lookup = { .idx = (uint32_t)map->keys.elem_count, .key = key, .keys = map->keys.elems }; \
+        if (!hash_table_insert(&map->hash_table, &lookup, NULL, sizeof(uint32_t), 0, hash(map->hash_table.seed, key), name##_is_equal_wrapper)) \
+            return false; \
+        name##_key_vec_push(&map->keys, key); \
+        name##_val_vec_push(&map->vals, val); \
+        if (hash_table_needs_rehash(&map->hash_table, map->keys.elem_count - 1)) \
+            hash_table_grow(&map->hash_table, sizeof(uint32_t), 0); \
+        return true; \
+    } \
+    VISIBILITY(vis) bool name##_is_empty(const struct name* map) { \
+        return map->keys.elem_count == 0; \
+    } \
+    VISIBILITY(vis) val_ty const* name##_find(const struct name* map, key_ty const* key) { \
+        struct name##_lookup lookup = { .key = key, .keys = map->keys.elems }; \
+        size_t bucket_idx; \
+        if (!hash_table_find(&map->hash_table, &bucket_idx, &lookup, sizeof(uint32_t), hash(map->hash_table.seed, key), name##_is_equal_wrapper)) \
+           return NULL; \
+        return &map->vals.elems[*(const uint32_t*)hash_table_key(&map->hash_table, bucket_idx, sizeof(uint32_t))]; \
+    } \
+    VISIBILITY(vis) bool name##_remove(struct name* map, key_ty const* key) { \
+        struct name##_lookup lookup = { .key = key, .keys = map->keys.elems }; \
+        size_t bucket_idx; \
+        if (!hash_table_find(&map->hash_table, &bucket_idx, &lookup, sizeof(uint32_t), hash(map->hash_table.seed, key), name##_is_equal_wrapper)) \
+           return false; \
+        uint32_t idx = *(const uint32_t*)hash_table_key(&map->hash_table, bucket_idx, sizeof(uint32_t)); \
+        hash_table_remove_at(&map->hash_table, bucket_idx, sizeof(uint32_t), 0); \
+        uint32_t last_idx = (uint32_t)map->keys.elem_count - 1; \
+        if (idx != last_idx) { \
+            /* Move the last element into the hole, and update its index in the hash table. */ \
+            lookup.idx = last_idx; \
+            [[maybe_unused]] bool found = hash_table_find(&map->hash_table, &bucket_idx, &lookup, sizeof(uint32_t), \
+                hash(map->hash_table.seed, &map->keys.elems[last_idx]), name##_is_same_idx); \
+            assert(found); \
+            *(uint32_t*)hash_table_key(&map->hash_table, bucket_idx, sizeof(uint32_t)) = idx; \
+            map->keys.elems[idx] = map->keys.elems[last_idx]; \
+            map->vals.elems[idx] = map->vals.elems[last_idx]; \
+        } \
+        name##_key_vec_pop(&map->keys); \
+        name##_val_vec_pop(&map->vals); \
+        return true; \
+    }
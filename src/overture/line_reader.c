@@ -0,0 +1,116 @@
+#include "line_reader.h"
+#include "file.h"
+#include "map.h"
+#include "vec.h"
+#include "mem.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <stddef.h>
+#include <assert.h>
+
+VEC_DEFINE(line_offset_vec, size_t, PRIVATE)
+
+struct cached_file {
+    bool is_valid;
+    struct mapped_file mapped_file;
+    struct line_offset_vec line_offsets;
+};
+
+static inline uint32_t hash_file_name(uint32_t h, const char* const* file_name) {
+    return hash_string(h, *file_name);
+}
+
+static inline bool is_file_name_equal(const char* const* file_name, const char* const* other) {
+    return !strcmp(*file_name, *other);
+}
+
+MAP_DEFINE(cached_file_map, const char*, struct cached_file*, hash_file_name, is_file_name_equal, PRIVATE)
+
+// The line reader is the first member, so that the public object can be converted back.
+struct file_line_reader {
+    struct line_reader line_reader;
+    struct cached_file_map cached_files;
+};
+
+static struct cached_file* open_file(const char* file_name) {
+    struct cached_file* cached_file = xcalloc(1, sizeof(struct cached_file));
+    if (!map_file(file_name, &cached_file->mapped_file))
+        return cached_file;
+
+    // Record where every line starts. A terminator at the very end of the file does not start
+    // another line.
+    struct str_view rest = { .data = cached_file->mapped_file.data, .length = cached_file->mapped_file.size };
+    cached_file->line_offsets = line_offset_vec_create();
+    size_t offset = 0;
+    while (offset < cached_file->mapped_file.size) {
+        line_offset_vec_push(&cached_file->line_offsets, &offset);
+        size_t i = str_view_find_char(rest, '\n');
+        if (i == STR_VIEW_NOT_FOUND)
+            break;
+        offset += i + 1;
+        rest = str_view_shrink(rest, i + 1, 0);
+    }
+    // The end of the file acts as the start of a last, virtual line.
+    size_t end = cached_file->mapped_file.size;
+    line_offset_vec_push(&cached_file->line_offsets, &end);
+    cached_file->is_valid = true;
+    return cached_file;
+}
+
+static void close_file(struct cached_file* cached_file) {
+    if (cached_file->is_valid) {
+        unmap_file(&cached_file->mapped_file);
+        line_offset_vec_destroy(&cached_file->line_offsets);
+    }
+    free(cached_file);
+}
+
+static struct file_line read_line(void* data, const char* file_name, uint32_t line) {
+    struct file_line_reader* file_line_reader = data;
+    struct cached_file* const* found = cached_file_map_find(&file_line_reader->cached_files, &file_name);
+    struct cached_file* cached_file = NULL;
+    if (found) {
+        cached_file = *found;
+    } else {
+        cached_file = open_file(file_name);
+        size_t file_name_size = strlen(file_name) + 1;
+        char* file_name_copy = xmalloc(file_name_size);
+        xmemcpy(file_name_copy, file_name, file_name_size);
+        [[maybe_unused]] bool was_inserted = cached_file_map_insert(
+            &file_line_reader->cached_files, &(const char*) { file_name_copy }, &cached_file);
+        assert(was_inserted);
+    }
+
+    if (!cached_file->is_valid || line == 0 || line >= cached_file->line_offsets.elem_count)
+        return (struct file_line) {};
+
+    size_t begin = cached_file->line_offsets.elems[line - 1];
+    size_t end = cached_file->line_offsets.elems[line];
+    const char* contents = cached_file->mapped_file.data;
+    if (end > begin && contents[end - 1] == '\n')
+        end--;
+    if (end > begin && contents[end - 1] == '\r')
+        end--;
+    return (struct file_line) {
+        .is_valid = true,
+        .contents = { .data = contents + begin, .length = end - begin }
+    };
+}
+
+struct line_reader* file_line_reader_create(void) {
+    struct file_line_reader* file_line_reader = xmalloc(sizeof(struct file_line_reader));
+    file_line_reader->line_reader = (struct line_reader) { .data = file_line_reader, .read_line = read_line };
+    file_line_reader->cached_files = cached_file_map_create();
+    return &file_line_reader->line_reader;
+}
+
+void file_line_reader_destroy(struct line_reader* line_reader) {
+    struct file_line_reader* file_line_reader = (struct file_line_reader*)line_reader;
+    MAP_FOREACH(const char*, file_name, struct cached_file*, cached_file, file_line_reader->cached_files) {
+        free((char*)*file_name);
+        close_file(*cached_file);
+    }
+    cached_file_map_destroy(&file_line_reader->cached_files);
+    free(file_line_reader);
+}
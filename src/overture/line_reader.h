@@ -0,0 +1,19 @@
+#pragma once
+
+#include "log.h"
+
+/// @file
+///
+/// Line reader that reads lines from files on disk, for use with @ref log. Each file is mapped in
+/// memory the first time one of its lines is requested, at which point the offsets of all its
+/// lines are computed in a single pass. Files are cached by name, such that subsequent requests
+/// find any line in constant time, without reading the file again. Lines are returned without their
+/// terminator (`\n` or `\r\n`).
+
+/// Creates a line reader that reads lines from files on disk.
+/// @return A line reader, to be destroyed with @ref file_line_reader_destroy.
+[[nodiscard]] struct line_reader* file_line_reader_create(void);
+
+/// Destroys a line reader created with @ref file_line_reader_create, and unmaps all the files that
+/// it has read. Lines previously obtained from it are invalidated.
+void file_line_reader_destroy(struct line_reader*);
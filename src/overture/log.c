@@ -1,10 +1,15 @@
 #include "log.h"
 #include "mem.h"
 #include "term.h"
+#include "heap.h"
 
 #include <stdarg.h>
 #include <stdlib.h>
 #include <inttypes.h>
+#include <string.h>
+#include <assert.h>
+
+VEC_IMPL(log_deferred_msg_vec, struct log_deferred_msg, PUBLIC)
 
 struct styles {
     const char* msg;
@@ -19,7 +24,40 @@ static inline int count_digits(uint32_t i) {
     return count;
 }
 
-static inline void print_diagnostic(
+static inline void append_repeated(struct str* str, char c, size_t count) {
+    str_grow(str, count);
+    memset(str->data + str->length, c, count);
+    str->length += count;
+}
+
+static inline void append_uint(struct str* str, uint32_t i) {
+    char digits[10];
+    size_t digit_count = 0;
+    do {
+        digits[digit_count++] = (char)('0' + i % 10);
+        i /= 10;
+    } while (i > 0);
+    str_grow(str, digit_count);
+    while (digit_count-- > 0)
+        str->data[str->length++] = digits[digit_count];
+}
+
+// Appends the margin on the left of a diagnostic, followed by the separator. The line number may be
+// `NULL`, in which case the margin is left blank.
+static inline void append_margin(struct str* str, const struct styles* styles, int indent_size, const uint32_t* line) {
+    str_push(str, ' ');
+    str_append(str, STR_VIEW(styles->range));
+    append_repeated(str, ' ', indent_size - (line ? count_digits(*line) : 0));
+    if (line)
+        append_uint(str, *line);
+    str_append(str, STR_VIEW(styles->reset));
+    str_push(str, ' ');
+    str_append(str, STR_VIEW(styles->msg));
+    str_push(str, '|');
+    str_append(str, STR_VIEW(styles->reset));
+}
+
+static inline void format_diagnostic(
     struct log* log,
     const struct file_loc* loc,
     const struct styles* styles)
@@ -30,53 +68,36 @@ static inline void print_diagnostic(
 
     int indent_size = count_digits(loc->displayed_line);
 
-    fprintf(log->file, " %s%*s%s ", styles->range, indent_size, " ", styles->reset);
-    fprintf(log->file, "%s|%s\n", styles->msg, styles->reset);
+    append_margin(&log->buf, styles, indent_size, NULL);
+    str_push(&log->buf, '\n');
 
-    fprintf(log->file, " %s%*"PRIu32"%s ", styles->range, indent_size, loc->displayed_line, styles->reset);
-    fprintf(log->file, "%s|%s%.*s\n", styles->msg, styles->reset, (int)line.contents.length, line.contents.data);
+    append_margin(&log->buf, styles, indent_size, &loc->displayed_line);
+    str_append(&log->buf, line.contents);
+    str_push(&log->buf, '\n');
 
-    fprintf(log->file, " %s%*s%s ", styles->range, indent_size, " ", styles->reset);
-    fprintf(log->file, "%s|%s%*s", styles->msg, styles->reset, (int)loc->begin.col - 1, "");
-    fputs(styles->msg, log->file);
+    append_margin(&log->buf, styles, indent_size, NULL);
+    if (loc->begin.col > 1)
+        append_repeated(&log->buf, ' ', loc->begin.col - 1);
+    str_append(&log->buf, STR_VIEW(styles->msg));
     if (loc->begin.row == loc->end.row) {
-        for (size_t i = loc->begin.col; i < loc->end.col; ++i)
-            fputc('^', log->file);
+        if (loc->end.col > loc->begin.col)
+            append_repeated(&log->buf, '^', loc->end.col - loc->begin.col);
     } else {
-        fputc('^', log->file);
-        for (size_t i = loc->begin.col; i < line.contents.length; ++i)
-            fputc('.', log->file);
+        str_push(&log->buf, '^');
+        if (line.contents.length > loc->begin.col)
+            append_repeated(&log->buf, '.', line.contents.length - loc->begin.col);
     }
-    fputs(styles->reset, log->file);
-    fputc('\n', log->file);
+    str_append(&log->buf, STR_VIEW(styles->reset));
+    str_push(&log->buf, '\n');
 }
 
-void log_msg_from_args(
+static inline void format_text_msg(
     enum msg_tag tag,
     struct log* log,
     const struct file_loc* loc,
     const char* fmt,
     va_list args)
 {
-    if (log->warns_as_errors && tag == MSG_WARN)
-        tag = MSG_ERROR;
-
-    log->error_count += tag == MSG_ERROR ? 1 : 0;
-    log->warn_count  += tag == MSG_WARN ? 1 : 0;
-
-    if ((tag == MSG_ERROR && log->error_count > log->max_errors) ||
-        (tag == MSG_WARN  && log->warn_count > log->max_warns) ||
-        (tag == MSG_NOTE  && (log->disable_notes || log->was_last_msg_skipped)) ||
-        !log->file)
-    {
-        log->was_last_msg_skipped = true;
-        return;
-    }
-
-    log->was_last_msg_skipped = false;
-    if (tag != MSG_NOTE && (log->error_count + log->warn_count) > 1)
-        fprintf(log->file, "\n");
-
     static const char* msg_styles[] = {
         [MSG_ERROR] = TERM2(TERM_FG_RED, TERM_BOLD),
         [MSG_WARN ] = TERM2(TERM_FG_YELLOW, TERM_BOLD),
@@ -95,23 +116,360 @@ void log_msg_from_args(
         .reset = log->disable_colors ? "" : TERM1(TERM_RESET)
     };
 
-    fprintf(log->file, "%s%s%s: ", styles.msg, msg_header[tag], styles.reset);
-    vfprintf(log->file, fmt, args);
-    fprintf(log->file, "\n");
+    str_append(&log->buf, STR_VIEW(styles.msg));
+    str_append(&log->buf, STR_VIEW(msg_header[tag]));
+    str_append(&log->buf, STR_VIEW(styles.reset));
+    str_append(&log->buf, STR_VIEW(": "));
+    str_vprintf(&log->buf, fmt, args);
+    str_push(&log->buf, '\n');
 
     if (loc && loc->displayed_file_name) {
-        fprintf(log->file, "  in %s%s(%"PRIu32":%"PRIu32" - %"PRIu32":%"PRIu32")%s\n",
-            styles.range,
-            loc->displayed_file_name,
-            loc->displayed_line,
-            loc->begin.col,
-            loc->end.row - loc->begin.row + loc->displayed_line,
-            loc->end.col,
-            styles.reset);
+        str_append(&log->buf, STR_VIEW("  in "));
+        str_append(&log->buf, STR_VIEW(styles.range));
+        str_append(&log->buf, STR_VIEW(loc->displayed_file_name));
+        str_push(&log->buf, '(');
+        append_uint(&log->buf, loc->displayed_line);
+        str_push(&log->buf, ':');
+        append_uint(&log->buf, loc->begin.col);
+        str_append(&log->buf, STR_VIEW(" - "));
+        append_uint(&log->buf, loc->end.row - loc->begin.row + loc->displayed_line);
+        str_push(&log->buf, ':');
+        append_uint(&log->buf, loc->end.col);
+        str_push(&log->buf, ')');
+        str_append(&log->buf, STR_VIEW(styles.reset));
+        str_push(&log->buf, '\n');
 
         if (log->line_reader)
-            print_diagnostic(log, loc, &styles);
+            format_diagnostic(log, loc, &styles);
+    }
+}
+
+static inline char json_escape_char(char c) {
+    switch (c) {
+        case '"':  return '"';
+        case '\\': return '\\';
+        case '\b': return 'b';
+        case '\f': return 'f';
+        case '\n': return 'n';
+        case '\r': return 'r';
+        case '\t': return 't';
+        default:   return 0;
+    }
+}
+
+// Escapes the characters of the buffer that start at the given offset, in place, such that they
+// can be placed between quotes in a JSON string.
+static inline void escape_json(struct str* str, size_t offset) {
+    size_t escaped_length = str->length;
+    for (size_t i = offset; i < str->length; ++i) {
+        unsigned char c = str->data[i];
+        if (json_escape_char(c))
+            escaped_length += 1;
+        else if (c < 0x20)
+            escaped_length += 5;
+    }
+    if (escaped_length == str->length)
+        return;
+
+    str_grow(str, escaped_length - str->length);
+    for (size_t i = str->length, j = escaped_length; i-- > offset;) {
+        unsigned char c = str->data[i];
+        char escape = json_escape_char(c);
+        if (escape) {
+            str->data[--j] = escape;
+            str->data[--j] = '\\';
+        } else if (c < 0x20) {
+            static const char hex_digits[] = "0123456789abcdef";
+            j -= 6;
+            xmemcpy(str->data + j, "\\u00", 4);
+            str->data[j + 4] = hex_digits[c >> 4];
+            str->data[j + 5] = hex_digits[c & 15];
+        } else {
+            str->data[--j] = c;
+        }
+    }
+    str->length = escaped_length;
+}
+
+static inline void append_json_str(struct str* str, struct str_view str_view) {
+    size_t offset = str->length;
+    str_push(str, '"');
+    str_append(str, str_view);
+    escape_json(str, offset + 1);
+    str_push(str, '"');
+}
+
+static inline void append_json_pos(struct str* str, const char* name, uint32_t row, uint32_t col) {
+    str_push(str, '"');
+    str_append(str, STR_VIEW(name));
+    str_append(str, STR_VIEW("\":{\"row\":"));
+    append_uint(str, row);
+    str_append(str, STR_VIEW(",\"col\":"));
+    append_uint(str, col);
+    str_push(str, '}');
+}
+
+static inline void format_json_object(
+    enum msg_tag tag,
+    struct log* log,
+    const struct file_loc* loc,
+    const char* fmt,
+    va_list args)
+{
+    static const char* msg_tags[] = {
+        [MSG_ERROR] = "error",
+        [MSG_WARN ] = "warning",
+        [MSG_NOTE ] = "note"
+    };
+
+    str_append(&log->buf, STR_VIEW("{\"tag\":\""));
+    str_append(&log->buf, STR_VIEW(msg_tags[tag]));
+    str_append(&log->buf, STR_VIEW("\","));
+    if (loc && loc->displayed_file_name) {
+        str_append(&log->buf, STR_VIEW("\"file\":"));
+        append_json_str(&log->buf, STR_VIEW(loc->displayed_file_name));
+        str_push(&log->buf, ',');
+        append_json_pos(&log->buf, "begin", loc->displayed_line, loc->begin.col);
+        str_push(&log->buf, ',');
+        append_json_pos(&log->buf, "end", loc->end.row - loc->begin.row + loc->displayed_line, loc->end.col);
+        str_push(&log->buf, ',');
+    }
+    str_append(&log->buf, STR_VIEW("\"message\":\""));
+    size_t msg_offset = log->buf.length;
+    str_vprintf(&log->buf, fmt, args);
+    escape_json(&log->buf, msg_offset);
+    str_append(&log->buf, STR_VIEW("\"}"));
+}
+
+// Formats a message as a JSON object on its own line. Notes are added to the last record in the
+// buffer, if that record is a JSON record produced by this log, and otherwise form a record of
+// their own. Records are always terminated in the buffer, which means that adding a note first
+// removes the end of that record.
+static inline void format_json_msg(
+    enum msg_tag tag,
+    struct log* log,
+    const struct file_loc* loc,
+    const char* fmt,
+    va_list args)
+{
+    if (tag == MSG_NOTE && log->last_record != LOG_LAST_RECORD_NONE) {
+        assert(log->buf.length >= 3);
+        if (log->last_record == LOG_LAST_RECORD_JSON_NOTES) {
+            log->buf.length -= 3;
+            str_push(&log->buf, ',');
+        } else {
+            log->buf.length -= 2;
+            str_append(&log->buf, STR_VIEW(",\"notes\":["));
+        }
+        format_json_object(tag, log, loc, fmt, args);
+        str_append(&log->buf, STR_VIEW("]}\n"));
+        log->last_record = LOG_LAST_RECORD_JSON_NOTES;
+        return;
+    }
+    format_json_object(tag, log, loc, fmt, args);
+    str_push(&log->buf, '\n');
+    log->last_record = LOG_LAST_RECORD_JSON;
+}
+
+static inline void format_msg(
+    enum msg_tag tag,
+    struct log* log,
+    const struct file_loc* loc,
+    const char* fmt,
+    va_list args)
+{
+    if (log->format == LOG_FORMAT_JSON) {
+        format_json_msg(tag, log, loc, fmt, args);
+    } else {
+        format_text_msg(tag, log, loc, fmt, args);
+        log->last_record = LOG_LAST_RECORD_NONE;
+    }
+}
+
+static inline void write_buf(struct log* log, size_t offset, size_t length) {
+    fwrite(log->buf.data + offset, 1, length, log->file);
+}
+
+// Writes the contents of the buffer of a log that is not in deferred mode, which may contain a JSON
+// record waiting for its notes.
+static inline void write_pending(struct log* log) {
+    if (log->buf.length > 0)
+        write_buf(log, 0, log->buf.length);
+    str_clear(&log->buf);
+    log->last_record = LOG_LAST_RECORD_NONE;
+}
+
+static inline size_t count_msg(atomic_size_t* count, bool is_counted) {
+    return is_counted
+        ? atomic_fetch_add_explicit(count, 1, memory_order_relaxed) + 1
+        : atomic_load_explicit(count, memory_order_relaxed);
+}
+
+static inline void defer_msg(enum msg_tag tag, struct log* log, const struct file_loc* loc, size_t offset) {
+    if (tag == MSG_NOTE && !log_deferred_msg_vec_is_empty(&log->deferred_msgs)) {
+        // Notes are formatted right after the message that they are attached to, and thus only
+        // extend that message.
+        struct log_deferred_msg* last = log_deferred_msg_vec_last(&log->deferred_msgs);
+        last->length = log->buf.length - last->offset;
+        return;
+    }
+    size_t length = log->buf.length - offset;
+    bool has_loc = loc && loc->displayed_file_name;
+    log_deferred_msg_vec_push(&log->deferred_msgs, &(struct log_deferred_msg) {
+        .file_name = has_loc ? loc->displayed_file_name : NULL,
+        .begin = has_loc ? (struct source_pos) { .row = loc->displayed_line, .col = loc->begin.col } : (struct source_pos) {},
+        .index = log->deferred_msgs.elem_count,
+        .offset = offset,
+        .length = length
+    });
+}
+
+void log_msg_from_args(
+    enum msg_tag tag,
+    struct log* log,
+    const struct file_loc* loc,
+    const char* fmt,
+    va_list args)
+{
+    if (log->warns_as_errors && tag == MSG_WARN)
+        tag = MSG_ERROR;
+
+    // Child logs count their messages in their parent as well, and use the counts of the parent to
+    // enforce the limits, such that these limits apply to all children together.
+    size_t error_count = count_msg(&log->error_count, tag == MSG_ERROR);
+    size_t warn_count  = count_msg(&log->warn_count, tag == MSG_WARN);
+    if (log->parent) {
+        error_count = count_msg(&log->parent->error_count, tag == MSG_ERROR);
+        warn_count  = count_msg(&log->parent->warn_count, tag == MSG_WARN);
+    }
+
+    if ((tag == MSG_ERROR && error_count > log->max_errors) ||
+        (tag == MSG_WARN  && warn_count > log->max_warns) ||
+        (tag == MSG_NOTE  && (log->disable_notes || log->was_last_msg_skipped)) ||
+        !log->file)
+    {
+        log->was_last_msg_skipped = true;
+        return;
+    }
+
+    log->was_last_msg_skipped = false;
+    if (log->defer_msgs) {
+        size_t offset = log->buf.length;
+        format_msg(tag, log, loc, fmt, args);
+        defer_msg(tag, log, loc, offset);
+        return;
+    }
+
+    if (log->format == LOG_FORMAT_JSON) {
+        // Records are only written once all their notes are known.
+        if (tag != MSG_NOTE)
+            write_pending(log);
+        format_json_msg(tag, log, loc, fmt, args);
+        return;
     }
+
+    if (tag != MSG_NOTE && (error_count + warn_count) > 1)
+        str_push(&log->buf, '\n');
+    format_text_msg(tag, log, loc, fmt, args);
+    write_pending(log);
+}
+
+static bool is_deferred_msg_less_than(const void* left, const void* right) {
+    const struct log_deferred_msg* left_msg = left;
+    const struct log_deferred_msg* right_msg = right;
+    if (left_msg->file_name != right_msg->file_name) {
+        if (!left_msg->file_name || !right_msg->file_name)
+            return !left_msg->file_name;
+        int cmp = strcmp(left_msg->file_name, right_msg->file_name);
+        if (cmp != 0)
+            return cmp < 0;
+    }
+    if (left_msg->begin.row != right_msg->begin.row)
+        return left_msg->begin.row < right_msg->begin.row;
+    if (left_msg->begin.col != right_msg->begin.col)
+        return left_msg->begin.col < right_msg->begin.col;
+    return left_msg->index < right_msg->index;
+}
+
+void log_flush(struct log* log) {
+    if (!log->defer_msgs) {
+        write_pending(log);
+        return;
+    }
+    heap_sort(
+        log->deferred_msgs.elems,
+        log->deferred_msgs.elem_count,
+        sizeof(struct log_deferred_msg),
+        is_deferred_msg_less_than);
+    VEC_FOREACH(const struct log_deferred_msg, msg, log->deferred_msgs) {
+        if (msg != log->deferred_msgs.elems && log->format == LOG_FORMAT_TEXT)
+            fputc('\n', log->file);
+        write_buf(log, msg->offset, msg->length);
+    }
+    log_deferred_msg_vec_clear(&log->deferred_msgs);
+    str_clear(&log->buf);
+    log->last_record = LOG_LAST_RECORD_NONE;
+}
+
+struct log log_create_child(struct log* parent) {
+    assert(!parent->parent);
+    return (struct log) {
+        .file = parent->file,
+        .disable_colors = parent->disable_colors,
+        .disable_notes = parent->disable_notes,
+        .warns_as_errors = parent->warns_as_errors,
+        .max_errors = parent->max_errors,
+        .max_warns = parent->max_warns,
+        .line_reader = parent->line_reader,
+        .format = parent->format,
+        .defer_msgs = true,
+        .parent = parent
+    };
+}
+
+void log_merge(struct log* parent, struct log* children, size_t child_count) {
+    if (!parent->defer_msgs)
+        write_pending(parent);
+    // Messages that are counted in the parent but not in the children have already been written
+    // by the parent, and must be separated from the messages of the children.
+    size_t written_count = parent->error_count + parent->warn_count;
+    for (size_t i = 0; i < child_count; ++i) {
+        struct log* child = &children[i];
+        assert(child->parent == parent);
+        written_count -= child->error_count + child->warn_count;
+        VEC_FOREACH(const struct log_deferred_msg, msg, child->deferred_msgs) {
+            size_t offset = parent->buf.length;
+            str_append(&parent->buf, (struct str_view) { .data = child->buf.data + msg->offset, .length = msg->length });
+            log_deferred_msg_vec_push(&parent->deferred_msgs, &(struct log_deferred_msg) {
+                .file_name = msg->file_name,
+                .begin = msg->begin,
+                .index = parent->deferred_msgs.elem_count,
+                .offset = offset,
+                .length = msg->length
+            });
+        }
+        log_deferred_msg_vec_clear(&child->deferred_msgs);
+        str_clear(&child->buf);
+        child->last_record = LOG_LAST_RECORD_NONE;
+    }
+    // The last record of the parent now comes from a child, and notes must not be added to it.
+    parent->last_record = LOG_LAST_RECORD_NONE;
+    if (!parent->defer_msgs) {
+        if (parent->format == LOG_FORMAT_TEXT && written_count > 0 && !log_deferred_msg_vec_is_empty(&parent->deferred_msgs))
+            fputc('\n', parent->file);
+        // Write the messages as if the parent was in deferred mode.
+        parent->defer_msgs = true;
+        log_flush(parent);
+        parent->defer_msgs = false;
+    }
+}
+
+void log_destroy(struct log* log) {
+    // In JSON format, the last record waits in the buffer for its notes, and must not be lost.
+    if (!log->defer_msgs && log->file)
+        write_pending(log);
+    str_destroy(&log->buf);
+    log_deferred_msg_vec_destroy(&log->deferred_msgs);
 }
 
 void log_msg(enum msg_tag tag, struct log* log, const struct file_loc* loc, const char* fmt, ...) {
@@ -1,15 +1,34 @@
 #pragma once
 
 #include "str.h"
+#include "vec.h"
 
 #include <stddef.h>
 #include <stdio.h>
 #include <stdint.h>
+#include <stdatomic.h>
 
 /// @file
 ///
 /// Error or warning log information. This can be used to produce accurate error messages for
 /// compilers or parsers.
+///
+/// Every message is formatted into a buffer owned by the log, and written with a single call to
+/// `fwrite`, along with its location and source line. A log can also defer messages, in which case
+/// they are kept in memory until @ref log_flush is called, and then written sorted by location.
+/// Notes stay attached to the message that precedes them.
+///
+/// Messages are written either as text for terminals, or as JSON Lines (see @ref log_format) for
+/// tools: Every error or warning becomes one JSON object on its own line, with its tag, location
+/// (when known), and message text, and the notes that follow it in a `notes` array. Since a record
+/// is only complete once its notes are known, it is written when the next error or warning is
+/// emitted, or when @ref log_flush is called.
+///
+/// A log cannot be used by several threads at once. Instead, every thread can use its own child log
+/// (see @ref log_create_child), which formats messages in its own buffer, and counts errors and
+/// warnings in its parent log, atomically. Thus, the limits of the parent apply to all its children
+/// together. Once the threads are done, their messages are moved to the parent with @ref log_merge,
+/// which orders them by location, independently of how the threads were scheduled.
 
 /// Message type.
 enum msg_tag {
@@ -18,6 +37,19 @@ enum msg_tag {
     MSG_NOTE    ///< Note attached to either a warning or error message.
 };
 
+/// Output format of a log.
+enum log_format {
+    LOG_FORMAT_TEXT,    ///< Human-readable text, with optional colors and source lines.
+    LOG_FORMAT_JSON     ///< JSON Lines: One compact JSON object per message, with its notes.
+};
+
+/// Kind of the last record in the buffer of a log, which determines how JSON notes are added to it.
+enum log_last_record {
+    LOG_LAST_RECORD_NONE,           ///< No JSON record of this log that notes can be added to.
+    LOG_LAST_RECORD_JSON,           ///< JSON record of this log, without notes.
+    LOG_LAST_RECORD_JSON_NOTES      ///< JSON record of this log, with notes.
+};
+
 /// Position in a source file.
 struct source_pos {
     uint32_t row;   ///< Source file row (1-based).
@@ -39,11 +71,23 @@ struct file_line {
 };
 
 /// Opaque callback object to extract source file lines.
+/// @see file_line_reader_create.
 struct line_reader {
     void* data;
     struct file_line (*read_line)(void* data, const char* file_name, uint32_t line);
 };
 
+/// Message kept in memory by a log in deferred mode.
+struct log_deferred_msg {
+    const char* file_name;      ///< Displayed file name of the message, or `NULL`.
+    struct source_pos begin;    ///< Beginning of the location of the message.
+    size_t index;               ///< Position of the message in submission order.
+    size_t offset;              ///< Offset of the formatted message (and its notes) in the log buffer.
+    size_t length;              ///< Length of the formatted message (and its notes), in bytes.
+};
+
+VEC_DECL(log_deferred_msg_vec, struct log_deferred_msg, PUBLIC)
+
 /// User-facing application log containing error and warning messages.
 struct log {
     FILE* file;                         ///< Stream where messages are shown.
@@ -53,11 +97,39 @@ struct log {
     bool was_last_msg_skipped;          ///< Set to true if the last message shown in the log was not shown.
     size_t max_errors;                  ///< Maximum number of errors before the log stops displaying them.
     size_t max_warns;                   ///< Maximum number of warnings before the log stops displaying them.
-    size_t error_count;                 ///< Current number of errors.
-    size_t warn_count;                  ///< Current number of warnings.
+    atomic_size_t error_count;          ///< Current number of errors.
+    atomic_size_t warn_count;           ///< Current number of warnings.
     struct line_reader* line_reader;    ///< Source file accessor to print line diagnostics.
+    enum log_format format;             ///< Format of the messages written to the stream.
+    enum log_last_record last_record;   ///< Kind of the last record in the buffer.
+    bool defer_msgs;                    ///< Keeps messages in memory until @ref log_flush is called.
+    struct str buf;                     ///< Buffer where messages are formatted.
+    struct log_deferred_msg_vec deferred_msgs; ///< Messages kept in memory in deferred mode.
+    struct log* parent;                 ///< Log where errors and warnings are counted, for child logs.
 };
 
+/// Creates a child log, to be used by another thread than the one using the parent log. The child
+/// log has the same settings as its parent, keeps its messages in memory, and counts its errors and
+/// warnings both in itself and in its parent. The line reader of the parent, if any, is called from
+/// the thread using the child log, and must thus be thread-safe, or replaced in the child log.
+/// @param parent Parent log, which must not be a child log itself.
+[[nodiscard]] struct log log_create_child(struct log* parent);
+
+/// Moves the messages of child logs to their parent log. Messages are ordered by file name and
+/// position, then by the position of the child log in the given array, and then in submission order.
+/// If the parent log is in deferred mode, the messages are kept in memory until @ref log_flush is
+/// called, otherwise they are written immediately.
+void log_merge(struct log* parent, struct log* children, size_t child_count);
+
+/// Destroys the buffers of a log. A log that is not in deferred mode first writes the message that it
+/// still holds, if any, while deferred messages that have not been flushed are discarded.
+void log_destroy(struct log*);
+
+/// Writes the deferred messages of a log, sorted by file name and position, and then in submission
+/// order. The file names of deferred messages must remain valid until this function is called.
+/// Outside of deferred mode, this writes the last JSON record, if it is still waiting for notes.
+void log_flush(struct log*);
+
 /// Prints a log message.
 /// @param msg_tag Type of message to show.
 /// @param log The log where the message is printed.
@@ -9,20 +9,39 @@
 /// @file
 ///
 /// Hash map data structure providing fast insertion, search, and removal.
+/// Batches of elements can be inserted or searched for with `name##_insert_many` and
+/// `name##_find_many`, which hash the whole batch and prefetch the corresponding buckets first, so
+/// that the cache misses of independent elements overlap. Insertions also reserve space for the
+/// whole batch at once.
+///
+/// Memory usage can be controlled with `name##_reserve`, `name##_shrink_to_fit`, and
+/// `name##_set_load_factors`. Setting a non-zero minimum load factor makes the table shrink
+/// automatically when enough elements are removed.
+///
+/// When the hash of a key is already known, `name##_insert_with_hash` and `name##_find_with_hash`
+/// avoid computing it again. The hash must be the one returned by `name##_hash` for the same map,
+/// since it depends on the seed of the map (see @ref HASH_TABLE_SEEDED). Maps can also be
+/// searched with keys of another type (see @ref MAP_DEFINE_FIND_AS).
+///
+/// `name##_find_or_insert` returns a pointer to the value of an element, inserting the element if
+/// it does not exist, with a single probe sequence. The value of a newly inserted element is left
+/// uninitialized, so that it can be constructed in place.
 /// @see hash_table.
 
 /// @cond PRIVATE
 #define MAP_DEFAULT_CAPACITY 4
+#define MAP_BATCH_SIZE 16
 #define MAP_PREFIX map_very_long_prefix_
 
 #define MAP_FOREACH_COMMON(map, ...) \
-    for (size_t MAP_PREFIX##i = 0; MAP_PREFIX##i < (map).hash_table.capacity; ++MAP_PREFIX##i) \
-        if (hash_table_is_bucket_occupied(&(map).hash_table, MAP_PREFIX##i)) \
-            for (bool MAP_PREFIX##once = true; MAP_PREFIX##once; MAP_PREFIX##once = false) \
-                __VA_ARGS__
+    for (const struct hash_table* MAP_PREFIX##table = &(map).hash_table; MAP_PREFIX##table; MAP_PREFIX##table = MAP_PREFIX##table->old_table) \
+        for (size_t MAP_PREFIX##i = 0; MAP_PREFIX##i < MAP_PREFIX##table->capacity; ++MAP_PREFIX##i) \
+            if (hash_table_is_bucket_occupied(MAP_PREFIX##table, MAP_PREFIX##i)) \
+                for (bool MAP_PREFIX##once = true; MAP_PREFIX##once; MAP_PREFIX##once = false) \
+                    __VA_ARGS__
 
 #define MAP_FOREACH_ACCESS(ty, val, elems) \
-    for (ty* val = &((ty*)(elems))[MAP_PREFIX##i]; MAP_PREFIX##once; MAP_PREFIX##once = false) \
+    for (ty* val = &((ty*)MAP_PREFIX##table->elems)[MAP_PREFIX##i]; MAP_PREFIX##once; MAP_PREFIX##once = false) \
 /// @endcond
 
 /// Iterates over the keys and values of a map.
@@ -33,20 +52,20 @@
 /// @param map Expression evaluating to a hash map.
 #define MAP_FOREACH(key_ty, key, val_ty, val, map) \
     MAP_FOREACH_COMMON(map, \
-        MAP_FOREACH_ACCESS(key_ty const, key, (map).hash_table.keys) \
-        MAP_FOREACH_ACCESS(val_ty, val, (map).hash_table.vals))
+        MAP_FOREACH_ACCESS(key_ty const, key, keys) \
+        MAP_FOREACH_ACCESS(val_ty, val, vals))
 
 /// Iterates over the keys of a map.
 /// @see MAP_FOREACH.
 #define MAP_FOREACH_KEY(key_ty, key, map) \
     MAP_FOREACH_COMMON(map, \
-        MAP_FOREACH_ACCESS(key_ty const, key, (map).hash_table.keys)) \
+        MAP_FOREACH_ACCESS(key_ty const, key, keys)) \
 
 /// Iterates over the values of a map.
 /// @see MAP_FOREACH.
 #define MAP_FOREACH_VAL(val_ty, val, map) \
     MAP_FOREACH_COMMON(map, \
-        MAP_FOREACH_ACCESS(val_ty, val, (map).hash_table.vals))
+        MAP_FOREACH_ACCESS(val_ty, val, vals))
 
 /// Declares and implements a hash map.
 /// @param name Name of the structure representing the hash map.
@@ -60,6 +79,60 @@
     MAP_DECL(name, key_ty, val_ty, vis) \
     MAP_IMPL(name, key_ty, val_ty, hash, is_equal, vis)
 
+/// Declares and implements a hash map with the given hash table layout options.
+/// @param flags Layout options for the underlying hash table.
+/// @see MAP_DEFINE, MAP_IMPL_WITH_FLAGS, hash_table_flags.
+#define MAP_DEFINE_WITH_FLAGS(name, key_ty, val_ty, hash, is_equal, flags, vis) \
+    MAP_DECL(name, key_ty, val_ty, vis) \
+    MAP_IMPL_WITH_FLAGS(name, key_ty, val_ty, hash, is_equal, flags, vis)
+
+/// Declares and implements a hash map whose keys can be compared bitwise.
+/// @see MAP_DEFINE, MAP_IMPL_TRIVIAL.
+#define MAP_DEFINE_TRIVIAL(name, key_ty, val_ty, hash, vis) \
+    MAP_DECL(name, key_ty, val_ty, vis) \
+    MAP_IMPL_TRIVIAL(name, key_ty, val_ty, hash, vis)
+
+/// Declares and implements a function `name##_find_##suffix` that searches for an element of a
+/// hash map using a key of another type, for instance a string view in a map whose keys are
+/// `NULL`-terminated strings. This avoids converting the key to the type of the keys of the map.
+/// A function `name##_find_##suffix##_with_hash` is also generated, which takes a hash computed
+/// with the given hash function, starting from the seed of the map.
+/// @param name Name of the structure representing the hash map.
+/// @param suffix Suffix appended to the name of the generated function.
+/// @param key_ty Type of the keys in the hash map.
+/// @param val_ty Type of the values in the hash map.
+/// @param other_ty Type of the key used for the search.
+/// @param hash Hash function with signature `uint32 (uint32_t, const other_ty*)`, which must produce
+///   the same hash as the hash function of the map for keys that compare equal.
+/// @param is_equal Comparison function with signature `bool (const key_ty*, const other_ty*)`.
+/// @param vis Visibility of the implementation.
+/// @see MAP_DECL_FIND_AS, MAP_IMPL_FIND_AS.
+#define MAP_DEFINE_FIND_AS(name, suffix, key_ty, val_ty, other_ty, hash, is_equal, vis) \
+    MAP_DECL_FIND_AS(name, suffix, val_ty, other_ty, vis) \
+    MAP_IMPL_FIND_AS(name, suffix, key_ty, val_ty, other_ty, hash, is_equal, vis)
+
+/// Declares a function that searches for an element of a hash map using a key of another type.
+/// @see MAP_DEFINE_FIND_AS.
+#define MAP_DECL_FIND_AS(name, suffix, val_ty, other_ty, vis) \
+    VISIBILITY(vis) val_ty const* name##_find_##suffix(const struct name*, other_ty const*); \
+    VISIBILITY(vis) val_ty const* name##_find_##suffix##_with_hash(const struct name*, other_ty const*, uint32_t);
+
+/// Implements a function that searches for an element of a hash map using a key of another type.
+/// @see MAP_DEFINE_FIND_AS.
+#define MAP_IMPL_FIND_AS(name, suffix, key_ty, val_ty, other_ty, hash, is_equal, vis) \
+    static inline bool name##_is_equal_##suffix##_wrapper(const void* left, const void* right) { \
+        return is_equal((key_ty const*)left, (other_ty const*)right); \
+    } \
+    VISIBILITY(vis) val_ty const* name##_find_##suffix##_with_hash(const struct name* map, other_ty const* key, uint32_t key_hash) { \
+        size_t idx; \
+        if (!hash_table_find(&map->hash_table, &idx, key, sizeof(key_ty), key_hash, name##_is_equal_##suffix##_wrapper)) \
+           return NULL; \
+        return hash_table_val(&map->hash_table, idx, sizeof(val_ty)); \
+    } \
+    VISIBILITY(vis) val_ty const* name##_find_##suffix(const struct name* map, other_ty const* key) { \
+        return name##_find_##suffix##_with_hash(map, key, hash(map->hash_table.seed, key)); \
+    }
+
 /// Declares a hash map. Typically used in header files.
 /// @see MAP_DEFINE.
 #define MAP_DECL(name, key_ty, val_ty, vis) \
@@ -72,19 +145,49 @@
     VISIBILITY(vis) void name##_destroy(struct name*); \
     VISIBILITY(vis) void name##_clear(struct name*); \
     VISIBILITY(vis) bool name##_insert(struct name*, key_ty const*, val_ty const*); \
+    VISIBILITY(vis) bool name##_insert_with_hash(struct name*, key_ty const*, val_ty const*, uint32_t); \
+    VISIBILITY(vis) val_ty* name##_find_or_insert(struct name*, key_ty const*, bool*); \
     [[nodiscard]] VISIBILITY(vis) bool name##_is_empty(const struct name*); \
     VISIBILITY(vis) val_ty const* name##_find(const struct name*, key_ty const*); \
-    VISIBILITY(vis) bool name##_remove(struct name*, key_ty const*);
+    VISIBILITY(vis) val_ty const* name##_find_with_hash(const struct name*, key_ty const*, uint32_t); \
+    [[nodiscard]] VISIBILITY(vis) uint32_t name##_hash(const struct name*, key_ty const*); \
+    VISIBILITY(vis) bool name##_remove(struct name*, key_ty const*); \
+    VISIBILITY(vis) void name##_reserve(struct name*, size_t); \
+    VISIBILITY(vis) void name##_shrink_to_fit(struct name*); \
+    VISIBILITY(vis) void name##_set_load_factors(struct name*, unsigned, unsigned); \
+    VISIBILITY(vis) size_t name##_insert_many(struct name*, key_ty const*, val_ty const*, size_t); \
+    VISIBILITY(vis) size_t name##_find_many(const struct name*, key_ty const*, val_ty const**, size_t);
 
 /// Implements a hash map. Typically used in source files.
 /// @see MAP_DEFINE.
 #define MAP_IMPL(name, key_ty, val_ty, hash, is_equal, vis) \
-    static inline bool name##_is_equal_wrapper(const void* left, const void* right) { \
-        return is_equal((key_ty const*)left, (key_ty const*)right); \
-    } \
+    MAP_IMPL_WITH_FLAGS(name, key_ty, val_ty, hash, is_equal, HASH_TABLE_DEFAULT, vis)
+
+/// Implements a hash map with the given hash table layout options. The declaration is the same as
+/// for other hash maps, which means that the layout can be changed without modifying header files.
+/// @see MAP_DEFINE_WITH_FLAGS.
+#define MAP_IMPL_WITH_FLAGS(name, key_ty, val_ty, hash, is_equal, flags, vis) \
+    HASH_TABLE_GENERIC_IMPL(name, key_ty, sizeof(val_ty), is_equal) \
+    MAP_IMPL_COMMON(name, key_ty, val_ty, hash, flags, vis)
+
+/// Implements a hash map whose keys can be compared bitwise, such as integers or pointers. Instead of
+/// calling a comparison function through a pointer, the probe loops are specialized for the type of
+/// the keys, which compare keys with `memcmp`. The key type must not contain any padding.
+/// @see MAP_DEFINE_TRIVIAL.
+#define MAP_IMPL_TRIVIAL(name, key_ty, val_ty, hash, vis) \
+    MAP_IMPL_TRIVIAL_WITH_FLAGS(name, key_ty, val_ty, hash, HASH_TABLE_DEFAULT, vis)
+
+/// Implements a hash map whose keys can be compared bitwise, with the given hash table layout options.
+/// @see MAP_IMPL_TRIVIAL, MAP_IMPL_WITH_FLAGS.
+#define MAP_IMPL_TRIVIAL_WITH_FLAGS(name, key_ty, val_ty, hash, flags, vis) \
+    HASH_TABLE_TRIVIAL_IMPL(name, key_ty, sizeof(val_ty)) \
+    MAP_IMPL_COMMON(name, key_ty, val_ty, hash, flags, vis)
+
+/// @cond PRIVATE
+#define MAP_IMPL_COMMON(name, key_ty, val_ty, hash, flags, vis) \
     VISIBILITY(vis) struct name name##_create_with_capacity(size_t capacity) { \
         return (struct name) { \
-            .hash_table = hash_table_create(sizeof(key_ty), sizeof(val_ty), capacity) \
+            .hash_table = hash_table_create(sizeof(key_ty), sizeof(val_ty), capacity, flags) \
         }; \
     } \
     VISIBILITY(vis) struct name name##_create(void) { \
@@ -97,27 +200,90 @@
         hash_table_clear(&map->hash_table); \
         map->elem_count = 0; \
     } \
+    VISIBILITY(vis) uint32_t name##_hash(const struct name* map, key_ty const* key) { \
+        return hash(map->hash_table.seed, key); \
+    } \
+    VISIBILITY(vis) bool name##_insert_with_hash(struct name* map, key_ty const* key, val_ty const* val, uint32_t key_hash) { \
+        size_t idx; \
+        if (!name##_table_find_or_insert(&map->hash_table, &idx, key, key_hash)) \
+            return false; \
+        memcpy(hash_table_val(&map->hash_table, idx, sizeof(val_ty)), val, sizeof(val_ty)); \
+        if (hash_table_needs_rehash(&map->hash_table, map->elem_count++)) \
+            hash_table_grow(&map->hash_table, sizeof(key_ty), sizeof(val_ty)); \
+        return true; \
+    } \
+    VISIBILITY(vis) val_ty const* name##_find_with_hash(const struct name* map, key_ty const* key, uint32_t key_hash) { \
+        size_t idx; \
+        if (!name##_table_find(&map->hash_table, &idx, key, key_hash)) \
+           return NULL; \
+        return hash_table_val(&map->hash_table, idx, sizeof(val_ty)); \
+    } \
     VISIBILITY(vis) bool name##_insert(struct name* map, key_ty const* key, val_ty const* val) { \
-        if (hash_table_insert(&map->hash_table, key, val, sizeof(key_ty), sizeof(val_ty), hash(hash_init(), key), name##_is_equal_wrapper)) { \
-            if (hash_table_needs_rehash(&map->hash_table, map->elem_count++)) \
-                hash_table_grow(&map->hash_table, sizeof(key_ty), sizeof(val_ty)); \
-            return true; \
-        } \
-        return false; \
+        return name##_insert_with_hash(map, key, val, name##_hash(map, key)); \
+    } \
+    VISIBILITY(vis) val_ty* name##_find_or_insert(struct name* map, key_ty const* key, bool* inserted) { \
+        if (hash_table_needs_rehash(&map->hash_table, map->elem_count)) \
+            hash_table_grow(&map->hash_table, sizeof(key_ty), sizeof(val_ty)); \
+        size_t idx; \
+        *inserted = name##_table_find_or_insert(&map->hash_table, &idx, key, name##_hash(map, key)); \
+        map->elem_count += *inserted ? 1 : 0; \
+        return hash_table_val(&map->hash_table, idx, sizeof(val_ty)); \
     } \
     VISIBILITY(vis) bool name##_is_empty(const struct name* map) { \
         return map->elem_count == 0; \
     } \
     VISIBILITY(vis) val_ty const* name##_find(const struct name* map, key_ty const* key) { \
-        size_t idx; \
-        if (!hash_table_find(&map->hash_table, &idx, key, sizeof(key_ty), hash(hash_init(), key), name##_is_equal_wrapper)) \
-           return NULL; \
-        return ((val_ty const*)map->hash_table.vals) + idx; \
+        return name##_find_with_hash(map, key, name##_hash(map, key)); \
     } \
     VISIBILITY(vis) bool name##_remove(struct name* map, key_ty const* key) { \
-        if (hash_table_remove(&map->hash_table, key, sizeof(key_ty), sizeof(val_ty), hash(hash_init(), key), name##_is_equal_wrapper)) { \
-            map->elem_count--; \
+        if (name##_table_remove(&map->hash_table, key, name##_hash(map, key))) { \
+            if (hash_table_needs_shrink(&map->hash_table, --map->elem_count)) { \
+                hash_table_shrink(&map->hash_table, sizeof(key_ty), sizeof(val_ty), map->elem_count, \
+                    (map->hash_table.min_load_factor + map->hash_table.max_load_factor) / 2); \
+            } \
             return true; \
         } \
         return false; \
+    } \
+    VISIBILITY(vis) void name##_reserve(struct name* map, size_t elem_count) { \
+        hash_table_reserve(&map->hash_table, sizeof(key_ty), sizeof(val_ty), elem_count); \
+    } \
+    VISIBILITY(vis) void name##_shrink_to_fit(struct name* map) { \
+        hash_table_shrink(&map->hash_table, sizeof(key_ty), sizeof(val_ty), map->elem_count, map->hash_table.max_load_factor); \
+    } \
+    VISIBILITY(vis) void name##_set_load_factors(struct name* map, unsigned min_load_factor, unsigned max_load_factor) { \
+        hash_table_set_load_factors(&map->hash_table, min_load_factor, max_load_factor); \
+        hash_table_reserve(&map->hash_table, sizeof(key_ty), sizeof(val_ty), map->elem_count); \
+    } \
+    VISIBILITY(vis) size_t name##_insert_many(struct name* map, key_ty const* keys, val_ty const* vals, size_t count) { \
+        hash_table_reserve(&map->hash_table, sizeof(key_ty), sizeof(val_ty), map->elem_count + count); \
+        uint32_t hashes[MAP_BATCH_SIZE]; \
+        size_t inserted_count = 0; \
+        for (size_t i = 0; i < count; i += MAP_BATCH_SIZE) { \
+            size_t batch_size = count - i < MAP_BATCH_SIZE ? count - i : MAP_BATCH_SIZE; \
+            for (size_t j = 0; j < batch_size; ++j) { \
+                hashes[j] = name##_hash(map, &keys[i + j]); \
+                hash_table_prefetch(&map->hash_table, sizeof(key_ty), hashes[j]); \
+            } \
+            for (size_t j = 0; j < batch_size; ++j) \
+                inserted_count += name##_insert_with_hash(map, &keys[i + j], &vals[i + j], hashes[j]) ? 1 : 0; \
+        } \
+        return inserted_count; \
+    } \
+    VISIBILITY(vis) size_t name##_find_many(const struct name* map, key_ty const* keys, val_ty const** found_vals, size_t count) { \
+        uint32_t hashes[MAP_BATCH_SIZE]; \
+        size_t found_count = 0; \
+        for (size_t i = 0; i < count; i += MAP_BATCH_SIZE) { \
+            size_t batch_size = count - i < MAP_BATCH_SIZE ? count - i : MAP_BATCH_SIZE; \
+            for (size_t j = 0; j < batch_size; ++j) { \
+                hashes[j] = name##_hash(map, &keys[i + j]); \
+                hash_table_prefetch(&map->hash_table, sizeof(key_ty), hashes[j]); \
+            } \
+            for (size_t j = 0; j < batch_size; ++j) { \
+                found_vals[i + j] = name##_find_with_hash(map, &keys[i + j], hashes[j]); \
+                found_count += found_vals[i + j] ? 1 : 0; \
+            } \
+        } \
+        return found_count; \
     }
+/// @endcond
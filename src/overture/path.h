@@ -13,18 +13,14 @@
 
 /// @return The file name without the directory part.
 [[nodiscard]] static inline struct str_view skip_dir(struct str_view path) {
-    for (size_t i = path.length; i-- > 0;) {
-        if (is_path_separator(path.data[i]))
-            return str_view_shrink(path, i + 1, 0);
-    }
-    return path;
+    // Adding one maps a missing separator (`STR_VIEW_NOT_FOUND`) to the beginning of the path.
+    size_t slash = str_view_find_last_char(path, '/') + 1;
+    size_t backslash = str_view_find_last_char(path, '\\') + 1;
+    return str_view_shrink(path, slash > backslash ? slash : backslash, 0);
 }
 
 /// @return The path or file name without its extension.
 [[nodiscard]] static inline struct str_view trim_ext(struct str_view path) {
-    for (size_t i = path.length; i-- > 0;) {
-        if (path.data[i] == '.')
-            return str_view_shrink(path, 0, path.length - i);
-    }
-    return path;
+    size_t i = str_view_find_last_char(path, '.');
+    return i == STR_VIEW_NOT_FOUND ? path : str_view_substr(path, 0, i);
 }
@@ -9,10 +9,28 @@
 /// @file
 ///
 /// Hash set data structure providing fast insertion, search, and removal.
+/// Batches of elements can be inserted or searched for with `name##_insert_many` and
+/// `name##_find_many`, which hash the whole batch and prefetch the corresponding buckets first, so
+/// that the cache misses of independent elements overlap. Insertions also reserve space for the
+/// whole batch at once.
+///
+/// Memory usage can be controlled with `name##_reserve`, `name##_shrink_to_fit`, and
+/// `name##_set_load_factors`. Setting a non-zero minimum load factor makes the table shrink
+/// automatically when enough elements are removed.
+///
+/// When the hash of an element is already known, `name##_insert_with_hash` and
+/// `name##_find_with_hash` avoid computing it again. The hash must be the one returned by
+/// `name##_hash` for the same set, since it depends on the seed of the set (see
+/// @ref HASH_TABLE_SEEDED). Sets can also be searched with values of another type (see
+/// @ref SET_DEFINE_FIND_AS).
+///
+/// `name##_find_or_insert` returns a pointer to an element equal to the given one, inserting it if
+/// it does not exist, with a single probe sequence.
 /// @see hash_table.
 
 /// @cond PRIVATE
 #define SET_DEFAULT_CAPACITY 4
+#define SET_BATCH_SIZE 16
 #define SET_PREFIX set_very_long_prefix_
 /// @endcond
 
@@ -21,10 +39,11 @@
 /// @param elem Name of the variable holding a pointer to the current element.
 /// @param set Expression evaluating to a hash set.
 #define SET_FOREACH(elem_ty, elem, set) \
-    for (size_t SET_PREFIX##i = 0; SET_PREFIX##i < (set).hash_table.capacity; ++SET_PREFIX##i) \
-        if (hash_table_is_bucket_occupied(&(set).hash_table, SET_PREFIX##i)) \
-            for (bool SET_PREFIX##once = true; SET_PREFIX##once; SET_PREFIX##once = false) \
-                for (elem_ty const* elem = &((elem_ty const*)(set).hash_table.keys)[SET_PREFIX##i]; SET_PREFIX##once; SET_PREFIX##once = false) \
+    for (const struct hash_table* SET_PREFIX##table = &(set).hash_table; SET_PREFIX##table; SET_PREFIX##table = SET_PREFIX##table->old_table) \
+        for (size_t SET_PREFIX##i = 0; SET_PREFIX##i < SET_PREFIX##table->capacity; ++SET_PREFIX##i) \
+            if (hash_table_is_bucket_occupied(SET_PREFIX##table, SET_PREFIX##i)) \
+                for (bool SET_PREFIX##once = true; SET_PREFIX##once; SET_PREFIX##once = false) \
+                    for (elem_ty const* elem = &((elem_ty const*)SET_PREFIX##table->keys)[SET_PREFIX##i]; SET_PREFIX##once; SET_PREFIX##once = false) \
 
 /// Declares and implements a hash set.
 /// @param name Name of the structure representing the hash set.
@@ -37,6 +56,57 @@
     SET_DECL(name, elem_ty, vis) \
     SET_IMPL(name, elem_ty, hash, is_equal, vis)
 
+/// Declares and implements a hash set with the given hash table layout options.
+/// @param flags Layout options for the underlying hash table.
+/// @see SET_DEFINE, SET_IMPL_WITH_FLAGS, hash_table_flags.
+#define SET_DEFINE_WITH_FLAGS(name, elem_ty, hash, is_equal, flags, vis) \
+    SET_DECL(name, elem_ty, vis) \
+    SET_IMPL_WITH_FLAGS(name, elem_ty, hash, is_equal, flags, vis)
+
+/// Declares and implements a hash set whose elements can be compared bitwise.
+/// @see SET_DEFINE, SET_IMPL_TRIVIAL.
+#define SET_DEFINE_TRIVIAL(name, elem_ty, hash, vis) \
+    SET_DECL(name, elem_ty, vis) \
+    SET_IMPL_TRIVIAL(name, elem_ty, hash, vis)
+
+/// Declares and implements a function `name##_find_##suffix` that searches for an element of a
+/// hash set using a value of another type, as well as `name##_find_##suffix##_with_hash`, which
+/// takes a hash computed with the given hash function, starting from the seed of the set.
+/// @param name Name of the structure representing the hash set.
+/// @param suffix Suffix appended to the name of the generated function.
+/// @param elem_ty Type of the elements in the hash set.
+/// @param other_ty Type of the value used for the search.
+/// @param hash Hash function with signature `uint32 (uint32_t, const other_ty*)`, which must produce
+///   the same hash as the hash function of the set for values that compare equal.
+/// @param is_equal Comparison function with signature `bool (const elem_ty*, const other_ty*)`.
+/// @param vis Visibility of the implementation.
+/// @see SET_DECL_FIND_AS, SET_IMPL_FIND_AS, MAP_DEFINE_FIND_AS.
+#define SET_DEFINE_FIND_AS(name, suffix, elem_ty, other_ty, hash, is_equal, vis) \
+    SET_DECL_FIND_AS(name, suffix, elem_ty, other_ty, vis) \
+    SET_IMPL_FIND_AS(name, suffix, elem_ty, other_ty, hash, is_equal, vis)
+
+/// Declares a function that searches for an element of a hash set using a value of another type.
+/// @see SET_DEFINE_FIND_AS.
+#define SET_DECL_FIND_AS(name, suffix, elem_ty, other_ty, vis) \
+    VISIBILITY(vis) elem_ty const* name##_find_##suffix(const struct name*, other_ty const*); \
+    VISIBILITY(vis) elem_ty const* name##_find_##suffix##_with_hash(const struct name*, other_ty const*, uint32_t);
+
+/// Implements a function that searches for an element of a hash set using a value of another type.
+/// @see SET_DEFINE_FIND_AS.
+#define SET_IMPL_FIND_AS(name, suffix, elem_ty, other_ty, hash, is_equal, vis) \
+    static inline bool name##_is_equal_##suffix##_wrapper(const void* left, const void* right) { \
+        return is_equal((elem_ty const*)left, (other_ty const*)right); \
+    } \
+    VISIBILITY(vis) elem_ty const* name##_find_##suffix##_with_hash(const struct name* set, other_ty const* elem, uint32_t elem_hash) { \
+        size_t idx; \
+        if (!hash_table_find(&set->hash_table, &idx, elem, sizeof(elem_ty), elem_hash, name##_is_equal_##suffix##_wrapper)) \
+           return NULL; \
+        return hash_table_key(&set->hash_table, idx, sizeof(elem_ty)); \
+    } \
+    VISIBILITY(vis) elem_ty const* name##_find_##suffix(const struct name* set, other_ty const* elem) { \
+        return name##_find_##suffix##_with_hash(set, elem, hash(set->hash_table.seed, elem)); \
+    }
+
 /// Declares a hash set. Typically used in header files.
 /// @see SET_DEFINE.
 #define SET_DECL(name, elem_ty, vis) \
@@ -49,19 +119,51 @@
     VISIBILITY(vis) void name##_destroy(struct name*); \
     VISIBILITY(vis) void name##_clear(struct name*); \
     VISIBILITY(vis) bool name##_insert(struct name*, elem_ty const*); \
+    VISIBILITY(vis) bool name##_insert_with_hash(struct name*, elem_ty const*, uint32_t); \
+    VISIBILITY(vis) elem_ty const* name##_find_or_insert(struct name*, elem_ty const*, bool*); \
     [[nodiscard]] VISIBILITY(vis) bool name##_is_empty(const struct name*); \
     VISIBILITY(vis) elem_ty const* name##_find(const struct name*, elem_ty const*); \
-    VISIBILITY(vis) bool name##_remove(struct name*, elem_ty const*);
+    VISIBILITY(vis) elem_ty const* name##_find_with_hash(const struct name*, elem_ty const*, uint32_t); \
+    [[nodiscard]] VISIBILITY(vis) uint32_t name##_hash(const struct name*, elem_ty const*); \
+    VISIBILITY(vis) bool name##_remove(struct name*, elem_ty const*); \
+    VISIBILITY(vis) void name##_reserve(struct name*, size_t); \
+    VISIBILITY(vis) void name##_shrink_to_fit(struct name*); \
+    VISIBILITY(vis) void name##_set_load_factors(struct name*, unsigned, unsigned); \
+    VISIBILITY(vis) size_t name##_insert_many(struct name*, elem_ty const*, size_t); \
+    VISIBILITY(vis) size_t name##_find_many(const struct name*, elem_ty const*, elem_ty const**, size_t);
 
 /// Implements a hash set. Typically used in source files.
 /// @see SET_DEFINE.
 #define SET_IMPL(name, elem_ty, hash, is_equal, vis) \
-    static inline bool name##_is_equal_wrapper(const void* left, const void* right) { \
-        return is_equal((elem_ty const*)left, (elem_ty const*)right); \
-    } \
+    SET_IMPL_WITH_FLAGS(name, elem_ty, hash, is_equal, HASH_TABLE_DEFAULT, vis)
+
+/// Implements a hash set with the given hash table layout options. The declaration is the same as
+/// for other hash sets, which means that the layout can be changed without modifying header files.
+/// @see SET_DEFINE_WITH_FLAGS.
+#define SET_IMPL_WITH_FLAGS(name, elem_ty, hash, is_equal, flags, vis) \
+    HASH_TABLE_GENERIC_IMPL(name, elem_ty, 0, is_equal) \
+    SET_IMPL_COMMON(name, elem_ty, hash, flags, vis)
+
+/// Implements a hash set whose elements can be compared bitwise, such as integers or pointers.
+/// Instead of calling a comparison function through a pointer, the probe loops are specialized for
+/// the element type, and compare elements with `memcmp`. The element type must therefore not
+/// contain any padding.
+/// @see SET_DEFINE_TRIVIAL.
+#define SET_IMPL_TRIVIAL(name, elem_ty, hash, vis) \
+    SET_IMPL_TRIVIAL_WITH_FLAGS(name, elem_ty, hash, HASH_TABLE_DEFAULT, vis)
+
+/// Implements a hash set whose elements can be compared bitwise, with the given hash table layout
+/// options.
+/// @see SET_IMPL_TRIVIAL, SET_IMPL_WITH_FLAGS.
+#define SET_IMPL_TRIVIAL_WITH_FLAGS(name, elem_ty, hash, flags, vis) \
+    HASH_TABLE_TRIVIAL_IMPL(name, elem_ty, 0) \
+    SET_IMPL_COMMON(name, elem_ty, hash, flags, vis)
+
+/// @cond PRIVATE
+#define SET_IMPL_COMMON(name, elem_ty, hash, flags, vis) \
     VISIBILITY(vis) struct name name##_create_with_capacity(size_t capacity) { \
         return (struct name) { \
-            .hash_table = hash_table_create(sizeof(elem_ty), 0, capacity) \
+            .hash_table = hash_table_create(sizeof(elem_ty), 0, capacity, flags) \
         }; \
     } \
     VISIBILITY(vis) struct name name##_create(void) { \
@@ -74,27 +176,89 @@
         hash_table_clear(&set->hash_table); \
         set->elem_count = 0; \
     } \
+    VISIBILITY(vis) uint32_t name##_hash(const struct name* set, elem_ty const* elem) { \
+        return hash(set->hash_table.seed, elem); \
+    } \
+    VISIBILITY(vis) bool name##_insert_with_hash(struct name* set, elem_ty const* elem, uint32_t elem_hash) { \
+        size_t idx; \
+        if (!name##_table_find_or_insert(&set->hash_table, &idx, elem, elem_hash)) \
+            return false; \
+        if (hash_table_needs_rehash(&set->hash_table, set->elem_count++)) \
+            hash_table_grow(&set->hash_table, sizeof(elem_ty), 0); \
+        return true; \
+    } \
+    VISIBILITY(vis) elem_ty const* name##_find_with_hash(const struct name* set, elem_ty const* elem, uint32_t elem_hash) { \
+        size_t idx; \
+        if (!name##_table_find(&set->hash_table, &idx, elem, elem_hash)) \
+           return NULL; \
+        return hash_table_key(&set->hash_table, idx, sizeof(elem_ty)); \
+    } \
     VISIBILITY(vis) bool name##_insert(struct name* set, elem_ty const* elem) { \
-        if (hash_table_insert(&set->hash_table, elem, NULL, sizeof(elem_ty), 0, hash(hash_init(), elem), name##_is_equal_wrapper)) { \
-            if (hash_table_needs_rehash(&set->hash_table, set->elem_count++)) \
-                hash_table_grow(&set->hash_table, sizeof(elem_ty), 0); \
-            return true; \
-        } \
-        return false; \
+        return name##_insert_with_hash(set, elem, name##_hash(set, elem)); \
+    } \
+    VISIBILITY(vis) elem_ty const* name##_find_or_insert(struct name* set, elem_ty const* elem, bool* inserted) { \
+        if (hash_table_needs_rehash(&set->hash_table, set->elem_count)) \
+            hash_table_grow(&set->hash_table, sizeof(elem_ty), 0); \
+        size_t idx; \
+        *inserted = name##_table_find_or_insert(&set->hash_table, &idx, elem, name##_hash(set, elem)); \
+        set->elem_count += *inserted ? 1 : 0; \
+        return hash_table_key(&set->hash_table, idx, sizeof(elem_ty)); \
     } \
     VISIBILITY(vis) bool name##_is_empty(const struct name* set) { \
         return set->elem_count == 0; \
     } \
     VISIBILITY(vis) elem_ty const* name##_find(const struct name* set, elem_ty const* elem) { \
-        size_t idx; \
-        if (!hash_table_find(&set->hash_table, &idx, elem, sizeof(elem_ty), hash(hash_init(), elem), name##_is_equal_wrapper)) \
-           return NULL; \
-        return ((elem_ty const*)set->hash_table.keys) + idx; \
+        return name##_find_with_hash(set, elem, name##_hash(set, elem)); \
     } \
     VISIBILITY(vis) bool name##_remove(struct name* set, elem_ty const* elem) { \
-        if (hash_table_remove(&set->hash_table, elem, sizeof(elem_ty), 0, hash(hash_init(), elem), name##_is_equal_wrapper)) { \
-            set->elem_count--; \
+        if (name##_table_remove(&set->hash_table, elem, name##_hash(set, elem))) { \
+            if (hash_table_needs_shrink(&set->hash_table, --set->elem_count)) { \
+                hash_table_shrink(&set->hash_table, sizeof(elem_ty), 0, set->elem_count, \
+                    (set->hash_table.min_load_factor + set->hash_table.max_load_factor) / 2); \
+            } \
             return true; \
         } \
         return false; \
+    } \
+    VISIBILITY(vis) void name##_reserve(struct name* set, size_t elem_count) { \
+        hash_table_reserve(&set->hash_table, sizeof(elem_ty), 0, elem_count); \
+    } \
+    VISIBILITY(vis) void name##_shrink_to_fit(struct name* set) { \
+        hash_table_shrink(&set->hash_table, sizeof(elem_ty), 0, set->elem_count, set->hash_table.max_load_factor); \
+    } \
+    VISIBILITY(vis) void name##_set_load_factors(struct name* set, unsigned min_load_factor, unsigned max_load_factor) { \
+        hash_table_set_load_factors(&set->hash_table, min_load_factor, max_load_factor); \
+        hash_table_reserve(&set->hash_table, sizeof(elem_ty), 0, set->elem_count); \
+    } \
+    VISIBILITY(vis) size_t name##_insert_many(struct name* set, elem_ty const* elems, size_t count) { \
+        hash_table_reserve(&set->hash_table, sizeof(elem_ty), 0, set->elem_count + count); \
+        uint32_t hashes[SET_BATCH_SIZE]; \
+        size_t inserted_count = 0; \
+        for (size_t i = 0; i < count; i += SET_BATCH_SIZE) { \
+            size_t batch_size = count - i < SET_BATCH_SIZE ? count - i : SET_BATCH_SIZE; \
+            for (size_t j = 0; j < batch_size; ++j) { \
+                hashes[j] = name##_hash(set, &elems[i + j]); \
+                hash_table_prefetch(&set->hash_table, sizeof(elem_ty), hashes[j]); \
+            } \
+            for (size_t j = 0; j < batch_size; ++j) \
+                inserted_count += name##_insert_with_hash(set, &elems[i + j], hashes[j]) ? 1 : 0; \
+        } \
+        return inserted_count; \
+    } \
+    VISIBILITY(vis) size_t name##_find_many(const struct name* set, elem_ty const* elems, elem_ty const** found_elems, size_t count) { \
+        uint32_t hashes[SET_BATCH_SIZE]; \
+        size_t found_count = 0; \
+        for (size_t i = 0; i < count; i += SET_BATCH_SIZE) { \
+            size_t batch_size = count - i < SET_BATCH_SIZE ? count - i : SET_BATCH_SIZE; \
+            for (size_t j = 0; j < batch_size; ++j) { \
+                hashes[j] = name##_hash(set, &elems[i + j]); \
+                hash_table_prefetch(&set->hash_table, sizeof(elem_ty), hashes[j]); \
+            } \
+            for (size_t j = 0; j < batch_size; ++j) { \
+                found_elems[i + j] = name##_find_with_hash(set, &elems[i + j], hashes[j]); \
+                found_count += found_elems[i + j] ? 1 : 0; \
+            } \
+        } \
+        return found_count; \
     }
+/// @endcond
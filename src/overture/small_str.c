@@ -0,0 +1,55 @@
+#include "small_str.h"
+#include "mem_pool.h"
+#include "mem.h"
+
+#include <stdio.h>
+#include <assert.h>
+
+void small_str_reserve(struct small_str* small_str, size_t added_bytes) {
+    struct str* str = &small_str->str;
+    if (str->length + added_bytes <= str->capacity)
+        return;
+
+    // Heap strings can be reallocated in place, while other strings must be moved.
+    if (small_str_is_on_heap(small_str)) {
+        str_grow(str, added_bytes);
+        return;
+    }
+
+    size_t capacity = str->capacity + (str->capacity >> 1);
+    if (str->length + added_bytes > capacity)
+        capacity = str->length + added_bytes;
+    char* data = small_str->mem_pool
+        ? mem_pool_alloc(small_str->mem_pool, capacity, 1)
+        : xmalloc(capacity);
+    if (str->length > 0)
+        xmemcpy(data, str->data, str->length);
+    str->data = data;
+    str->capacity = capacity;
+}
+
+void small_str_vprintf(struct small_str* small_str, const char* fmt, va_list args) {
+    struct str* str = &small_str->str;
+    size_t remaining_size = str->capacity - str->length;
+
+    va_list copy;
+    va_copy(copy, args);
+    int req_size = vsnprintf(str->data + str->length, remaining_size, fmt, copy);
+    va_end(copy);
+    assert(req_size >= 0);
+
+    // Once grown, the string has enough room for `str_vprintf` to format the text in one attempt.
+    if ((size_t)req_size >= remaining_size) {
+        small_str_reserve(small_str, req_size + 1);
+        str_vprintf(str, fmt, args);
+        return;
+    }
+    str->length += req_size;
+}
+
+void small_str_printf(struct small_str* small_str, const char* fmt, ...) {
+    va_list args;
+    va_start(args, fmt);
+    small_str_vprintf(small_str, fmt, args);
+    va_end(args);
+}
@@ -0,0 +1,84 @@
+#pragma once
+
+#include "str.h"
+
+#include <stddef.h>
+#include <stdarg.h>
+
+/// @file
+///
+/// Small strings, whose first @ref SMALL_STR_CAPACITY characters are stored in an inline buffer.
+/// Longer strings are moved to the heap, or to a memory pool if one was given on initialization,
+/// in which case building short or temporary strings does not call `malloc` at all.
+///
+/// The characters of a small string are held in its `str` member, which can be passed to the
+/// functions of @ref str.h that do not grow a string, such as @ref str_to_view or @ref str_clear.
+/// The functions that may grow a string have their own version here. Since the `str` member points
+/// to the inline buffer, a small string must not be copied after initialization.
+
+struct mem_pool;
+
+/// Number of characters stored inline in a small string.
+#define SMALL_STR_CAPACITY 64
+
+/// String whose first characters are stored inline, without any allocation.
+struct small_str {
+    struct str str;             ///< Characters of the string.
+    struct mem_pool* mem_pool;  ///< Pool to allocate from when growing, or `NULL` to use the heap.
+    char small_data[SMALL_STR_CAPACITY];
+};
+
+/// Initializes a small string. When the string outgrows its inline buffer, its data is allocated
+/// from the given memory pool, or from the heap if the memory pool is `NULL`. Data allocated from a
+/// memory pool remains valid until that memory pool is reset or destroyed, and growing the string
+/// again leaves the previous buffer unused until then.
+static inline void small_str_init(struct small_str* small_str, struct mem_pool* mem_pool) {
+    small_str->str = (struct str) {
+        .data = small_str->small_data,
+        .capacity = SMALL_STR_CAPACITY
+    };
+    small_str->mem_pool = mem_pool;
+}
+
+/// @return `true` if the data of a small string is allocated on the heap, `false` otherwise.
+[[nodiscard]] static inline bool small_str_is_on_heap(const struct small_str* small_str) {
+    return !small_str->mem_pool && small_str->str.data != small_str->small_data;
+}
+
+/// Makes sure that the given number of characters can be added to a small string without growing it.
+void small_str_reserve(struct small_str*, size_t added_bytes);
+
+static inline void small_str_grow(struct small_str* small_str, size_t added_bytes) {
+    if (small_str->str.length + added_bytes > small_str->str.capacity)
+        small_str_reserve(small_str, added_bytes);
+}
+
+static inline void small_str_push(struct small_str* small_str, char c) {
+    small_str_grow(small_str, 1);
+    str_push(&small_str->str, c);
+}
+
+static inline void small_str_append(struct small_str* small_str, struct str_view view) {
+    small_str_grow(small_str, view.length);
+    str_append(&small_str->str, view);
+}
+
+/// Makes sure the given small string is zero-terminated.
+/// @see str_terminate.
+static inline const char* small_str_terminate(struct small_str* small_str) {
+    small_str_grow(small_str, 1);
+    return str_terminate(&small_str->str);
+}
+
+/// Appends formatted text at the end of the given small string.
+/// @see small_str_printf.
+void small_str_vprintf(struct small_str*, const char* fmt, va_list args);
+
+/// Appends formatted text at the end of the given small string.
+[[gnu::format(printf, 2, 3)]]
+void small_str_printf(struct small_str*, const char* fmt, ...);
+
+static inline void small_str_destroy(struct small_str* small_str) {
+    if (small_str_is_on_heap(small_str))
+        str_destroy(&small_str->str);
+}
@@ -3,6 +3,7 @@
 #include "mem.h"
 #include "vec.h"
 #include "hash.h"
+#include "bits.h"
 
 #include <stdio.h>
 #include <stddef.h>
@@ -12,10 +13,23 @@
 #include <stdarg.h>
 #include <assert.h>
 
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#endif
+
 /// @file
 ///
 /// Strings and string views. Strings are manually allocated and freed, while string views represent
-/// lightweight references to a string in memory.
+/// lightweight references to a string in memory. Short or temporary strings can also be built in an
+/// inline buffer, or in a memory pool, with the small strings of @ref small_str.h.
+///
+/// String views can be searched for characters or strings, split on a separator, or split into
+/// lines. These functions scan several characters at a time using SIMD instructions when they are
+/// available (SSE2, AVX2, or NEON), and fall back to a scalar implementation otherwise.
 
 /// Constructs a string view from the given C string.
 #define STR_VIEW(x) ((struct str_view) { .data = (x), .length = strlen((x)) })
@@ -40,9 +54,7 @@ struct str {
 }
 
 [[nodiscard]] static inline uint32_t str_view_hash(uint32_t h, const struct str_view* str_view) {
-    for (size_t i = 0; i < str_view->length; ++i)
-        h = hash_uint8(h, str_view->data[i]);
-    return h;
+    return hash_bytes(h, str_view->data, str_view->length);
 }
 
 [[nodiscard]] static inline struct str str_create(void) {
@@ -60,6 +72,165 @@ struct str {
     return str_view_substr(str_view, left, str_view.length - left - right);
 }
 
+/// Index returned by the search functions on string views when nothing is found.
+#define STR_VIEW_NOT_FOUND SIZE_MAX
+
+/// @cond PRIVATE
+#if defined(__AVX2__)
+#define STR_VIEW_BLOCK_SIZE 32
+#else
+#define STR_VIEW_BLOCK_SIZE 16
+#endif
+
+// Returns a mask where bit `i` is set if the `i`-th character of the block is equal to `c`.
+static inline uint32_t str_view_block_match(const char* block, char c) {
+#if defined(__AVX2__)
+    __m256i chars = _mm256_loadu_si256((const __m256i*)block);
+    return (uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(chars, _mm256_set1_epi8(c)));
+#elif defined(__SSE2__)
+    __m128i chars = _mm_loadu_si128((const __m128i*)block);
+    return (uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(chars, _mm_set1_epi8(c)));
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+    static const uint8_t bits[STR_VIEW_BLOCK_SIZE] = { 1, 2, 4, 8, 16, 32, 64, 128, 1, 2, 4, 8, 16, 32, 64, 128 };
+    uint8x16_t eq = vandq_u8(vceqq_u8(vld1q_u8((const uint8_t*)block), vdupq_n_u8((uint8_t)c)), vld1q_u8(bits));
+    return vaddv_u8(vget_low_u8(eq)) | ((uint32_t)vaddv_u8(vget_high_u8(eq)) << 8);
+#else
+    uint32_t mask = 0;
+    for (size_t i = 0; i < STR_VIEW_BLOCK_SIZE; ++i)
+        mask |= (uint32_t)(block[i] == c) << i;
+    return mask;
+#endif
+}
+/// @endcond
+
+/// Finds the first occurrence of a character in a string view.
+/// @return The index of the character, or @ref STR_VIEW_NOT_FOUND.
+[[nodiscard]] static inline size_t str_view_find_char(struct str_view str_view, char c) {
+    size_t i = 0;
+    for (; i + STR_VIEW_BLOCK_SIZE <= str_view.length; i += STR_VIEW_BLOCK_SIZE) {
+        uint32_t mask = str_view_block_match(str_view.data + i, c);
+        if (mask != 0)
+            return i + count_trailing_zeros(mask);
+    }
+    for (; i < str_view.length; ++i) {
+        if (str_view.data[i] == c)
+            return i;
+    }
+    return STR_VIEW_NOT_FOUND;
+}
+
+/// Finds the last occurrence of a character in a string view.
+/// @return The index of the character, or @ref STR_VIEW_NOT_FOUND.
+[[nodiscard]] static inline size_t str_view_find_last_char(struct str_view str_view, char c) {
+    size_t i = str_view.length;
+    for (; i >= STR_VIEW_BLOCK_SIZE; i -= STR_VIEW_BLOCK_SIZE) {
+        uint32_t mask = str_view_block_match(str_view.data + i - STR_VIEW_BLOCK_SIZE, c);
+        if (mask != 0)
+            return i - 1 - (count_leading_zeros(mask) - (32 - STR_VIEW_BLOCK_SIZE));
+    }
+    while (i-- > 0) {
+        if (str_view.data[i] == c)
+            return i;
+    }
+    return STR_VIEW_NOT_FOUND;
+}
+
+/// Finds the first occurrence of a string in a string view. Candidate positions are those where
+/// both the first and the last characters of the searched string match, which are found one block
+/// at a time, and then compared in full.
+/// @return The index of the first character of the occurrence, or @ref STR_VIEW_NOT_FOUND.
+[[nodiscard]] static inline size_t str_view_find(struct str_view str_view, struct str_view needle) {
+    if (needle.length == 0)
+        return 0;
+    if (needle.length == 1)
+        return str_view_find_char(str_view, needle.data[0]);
+    if (needle.length > str_view.length)
+        return STR_VIEW_NOT_FOUND;
+
+    const char first = needle.data[0];
+    const char last = needle.data[needle.length - 1];
+    const size_t last_start = str_view.length - needle.length;
+    size_t i = 0;
+    for (; i + STR_VIEW_BLOCK_SIZE <= last_start + 1; i += STR_VIEW_BLOCK_SIZE) {
+        uint32_t mask =
+            str_view_block_match(str_view.data + i, first) &
+            str_view_block_match(str_view.data + i + needle.length - 1, last);
+        for (; mask != 0; mask &= mask - 1) {
+            size_t j = i + count_trailing_zeros(mask);
+            if (!memcmp(str_view.data + j + 1, needle.data + 1, needle.length - 2))
+                return j;
+        }
+    }
+    for (; i <= last_start; ++i) {
+        if (str_view.data[i] == first && !memcmp(str_view.data + i + 1, needle.data + 1, needle.length - 1))
+            return i;
+    }
+    return STR_VIEW_NOT_FOUND;
+}
+
+/// Iterator over the parts of a string view that are delimited by a separator character.
+/// @see str_view_split, str_view_split_next.
+struct str_view_split {
+    struct str_view rest;   ///< Part of the string view that has not been split yet.
+    char sep;               ///< Separator character.
+    bool is_done;           ///< `true` once the last part has been returned.
+};
+
+/// Splits a string view on the given separator. Consecutive separators delimit empty parts, and a
+/// string view of length `n` with `k` separators always has `k + 1` parts.
+[[nodiscard]] static inline struct str_view_split str_view_split(struct str_view str_view, char sep) {
+    return (struct str_view_split) { .rest = str_view, .sep = sep };
+}
+
+/// Obtains the next part of a split string view.
+/// @param part On success, contains the next part, which points into the original string view.
+/// @return `true` if there was a part left, otherwise `false`.
+[[nodiscard]] static inline bool str_view_split_next(struct str_view_split* split, struct str_view* part) {
+    if (split->is_done)
+        return false;
+    size_t i = str_view_find_char(split->rest, split->sep);
+    if (i == STR_VIEW_NOT_FOUND) {
+        *part = split->rest;
+        split->is_done = true;
+    } else {
+        *part = str_view_substr(split->rest, 0, i);
+        split->rest = str_view_shrink(split->rest, i + 1, 0);
+    }
+    return true;
+}
+
+/// Iterator over the lines of a string view.
+/// @see str_view_lines, str_view_lines_next.
+struct str_view_lines {
+    struct str_view rest;   ///< Part of the string view that has not been split yet.
+};
+
+/// Splits a string view into lines. Lines end with `\n` or `\r\n`, and the line terminators are
+/// not part of the lines. Contrary to @ref str_view_split, a terminator at the very end of the
+/// string view does not start another, empty line.
+[[nodiscard]] static inline struct str_view_lines str_view_lines(struct str_view str_view) {
+    return (struct str_view_lines) { .rest = str_view };
+}
+
+/// Obtains the next line of a string view.
+/// @param line On success, contains the next line, which points into the original string view.
+/// @return `true` if there was a line left, otherwise `false`.
+[[nodiscard]] static inline bool str_view_lines_next(struct str_view_lines* lines, struct str_view* line) {
+    if (lines->rest.length == 0)
+        return false;
+    size_t i = str_view_find_char(lines->rest, '\n');
+    if (i == STR_VIEW_NOT_FOUND) {
+        *line = lines->rest;
+        lines->rest = str_view_shrink(lines->rest, lines->rest.length, 0);
+    } else {
+        *line = str_view_substr(lines->rest, 0, i);
+        lines->rest = str_view_shrink(lines->rest, i + 1, 0);
+    }
+    if (line->length > 0 && line->data[line->length - 1] == '\r')
+        line->length--;
+    return true;
+}
+
 [[nodiscard]] static inline struct str str_copy(struct str_view view) {
     char* copy = xmalloc(view.length);
     xmemcpy(copy, view.data, view.length);
@@ -77,6 +248,8 @@ struct str {
     };
 }
 
+/// Releases the data of a string, and resets the string to an empty state. The caller becomes
+/// responsible for freeing the data.
 [[nodiscard]] static inline struct str_view str_release(struct str* str) {
     struct str_view data = str_to_view(str);
     *str = str_create();
@@ -125,24 +298,33 @@ static inline const char* str_terminate(struct str* str) {
 }
 
 /// Appends formatted text at the end of the given string.
-[[gnu::format(printf, 2, 3)]]
-static inline void str_printf(struct str* str, const char* fmt, ...) {
+/// @see str_printf.
+static inline void str_vprintf(struct str* str, const char* fmt, va_list args) {
     size_t remaining_size = str->capacity - str->length;
 
-    va_list args;
-    va_start(args, fmt);
-    int req_size = vsnprintf(str->data + str->length, remaining_size, fmt, args);
-    va_end(args);
+    va_list copy;
+    va_copy(copy, args);
+    int req_size = vsnprintf(str->data + str->length, remaining_size, fmt, copy);
+    va_end(copy);
 
     if ((size_t)req_size >= remaining_size) {
         str_grow(str, req_size + 1);
         remaining_size = str->capacity - str->length;
 
-        va_start(args, fmt);
-        req_size = vsnprintf(str->data + str->length, remaining_size, fmt, args);
-        va_end(args);
+        va_copy(copy, args);
+        req_size = vsnprintf(str->data + str->length, remaining_size, fmt, copy);
+        va_end(copy);
 
         assert((size_t)req_size < remaining_size);
-        str->length += req_size;
     }
+    str->length += req_size;
+}
+
+/// Appends formatted text at the end of the given string.
+[[gnu::format(printf, 2, 3)]]
+static inline void str_printf(struct str* str, const char* fmt, ...) {
+    va_list args;
+    va_start(args, fmt);
+    str_vprintf(str, fmt, args);
+    va_end(args);
 }
@@ -2,25 +2,122 @@
 #include "mem_pool.h"
 #include "mem.h"
 #include "set.h"
+#include "vec.h"
+#include "file.h"
 
+#include <stdio.h>
 #include <string.h>
+#include <assert.h>
 
-SET_DEFINE(str_view_set, struct str_view, str_view_hash, str_view_is_equal, PRIVATE)
+#define STR_POOL_SNAPSHOT_MAGIC "OVSTRPL1"
+#define STR_POOL_SNAPSHOT_BYTE_ORDER UINT32_C(0x01020304)
+#define STR_POOL_SNAPSHOT_EMPTY_BUCKET UINT32_MAX
+#define STR_POOL_SNAPSHOT_MIN_BUCKETS 8
+
+// Layout of a snapshot file: This header is followed by an array of offsets (one per id), the
+// buckets of the hash index, and the strings themselves, each preceded by their own header.
+struct str_pool_snapshot_header {
+    char magic[8];
+    uint32_t byte_order;
+    uint32_t str_count;
+    uint32_t bucket_count;
+    uint32_t bucket_shift;
+    uint64_t ids_offset;
+    uint64_t buckets_offset;
+    uint64_t data_offset;
+    uint64_t size;
+};
+
+// Bucket of the hash index of a snapshot, which uses linear probing.
+struct str_pool_snapshot_bucket {
+    uint32_t hash;
+    uint32_t offset;
+};
+
+struct str_pool_snapshot {
+    struct mapped_file mapped_file;
+    const struct str_pool_snapshot_header* header;
+    const uint32_t* ids;
+    const struct str_pool_snapshot_bucket* buckets;
+    const char* data;
+};
+
+static inline uint32_t hash_pool_str(uint32_t h, const char* const* str) {
+    return str_view_hash(h, &(struct str_view) { .data = *str, .length = str_pool_length(*str) });
+}
+
+static inline bool is_pool_str_equal(const char* const* str, const char* const* other) {
+    return *str == *other;
+}
+
+static inline bool is_pool_str_equal_to_view(const char* const* str, const struct str_view* str_view) {
+    return
+        str_pool_length(*str) == str_view->length &&
+        !memcmp(*str, str_view->data, str_view->length);
+}
+
+SET_DEFINE(str_set, const char*, hash_pool_str, is_pool_str_equal, PRIVATE)
+SET_DEFINE_FIND_AS(str_set, view, const char*, struct str_view, str_view_hash, is_pool_str_equal_to_view, PRIVATE)
+VEC_DEFINE(str_vec, const char*, PRIVATE)
 
 struct str_pool {
     struct mem_pool* mem_pool;
-    struct str_view_set str_view_set;
+    const struct str_pool_snapshot* snapshot;
+    uint32_t first_id;
+    struct str_set str_set;
+    struct str_vec strs;
 };
 
+static inline size_t snapshot_first_bucket(const struct str_pool_snapshot_header* header, uint32_t hash) {
+    return (size_t)((hash * HASH_TABLE_FIBONACCI_FACTOR) >> header->bucket_shift);
+}
+
+// Returns the string stored at the given offset in the data of a snapshot, or `NULL` if that
+// string does not lie within the file, which can only happen if the file is corrupted.
+static const char* snapshot_str(const struct str_pool_snapshot* snapshot, uint32_t offset) {
+    size_t data_size = snapshot->header->size - snapshot->header->data_offset;
+    if (offset % alignof(struct str_pool_header) != 0 || offset + sizeof(struct str_pool_header) > data_size)
+        return NULL;
+    const struct str_pool_header* header = (const struct str_pool_header*)(snapshot->data + offset);
+    const char* str = (const char*)(header + 1);
+    if (offset + sizeof(struct str_pool_header) + header->length >= data_size || str[header->length] != 0)
+        return NULL;
+    return str;
+}
+
+static const char* snapshot_find(const struct str_pool_snapshot* snapshot, struct str_view str_view, uint32_t hash) {
+    const struct str_pool_snapshot_header* header = snapshot->header;
+    size_t idx = snapshot_first_bucket(header, hash);
+    for (size_t i = 0; i < header->bucket_count; ++i, idx = (idx + 1) & (header->bucket_count - 1)) {
+        const struct str_pool_snapshot_bucket* bucket = &snapshot->buckets[idx];
+        if (bucket->offset == STR_POOL_SNAPSHOT_EMPTY_BUCKET)
+            return NULL;
+        if (bucket->hash != hash)
+            continue;
+        const char* str = snapshot_str(snapshot, bucket->offset);
+        if (str && is_pool_str_equal_to_view(&str, &str_view))
+            return str;
+    }
+    return NULL;
+}
+
 struct str_pool* str_pool_create(struct mem_pool* mem_pool) {
+    return str_pool_create_with_snapshot(mem_pool, NULL);
+}
+
+struct str_pool* str_pool_create_with_snapshot(struct mem_pool* mem_pool, const struct str_pool_snapshot* snapshot) {
     struct str_pool* str_pool = xmalloc(sizeof(struct str_pool));
     str_pool->mem_pool = mem_pool;
-    str_pool->str_view_set = str_view_set_create();
+    str_pool->snapshot = snapshot;
+    str_pool->first_id = snapshot ? snapshot->header->str_count : 0;
+    str_pool->str_set = str_set_create();
+    str_pool->strs = str_vec_create();
     return str_pool;
 }
 
 void str_pool_destroy(struct str_pool* str_pool) {
-    str_view_set_destroy(&str_pool->str_view_set);
+    str_set_destroy(&str_pool->str_set);
+    str_vec_destroy(&str_pool->strs);
     free(str_pool);
 }
 
@@ -28,9 +125,19 @@ const char* str_pool_find(struct str_pool* str_pool, const char* str) {
     return str_pool_find_view(str_pool, STR_VIEW(str));
 }
 
+// The set uses the default seed, which makes its hashes equal to those stored in the headers.
+static const char* find_with_hash(struct str_pool* str_pool, struct str_view str_view, uint32_t hash) {
+    if (str_pool->snapshot) {
+        const char* str = snapshot_find(str_pool->snapshot, str_view, hash);
+        if (str)
+            return str;
+    }
+    const char* const* found = str_set_find_view_with_hash(&str_pool->str_set, &str_view, hash);
+    return found ? *found : NULL;
+}
+
 const char* str_pool_find_view(struct str_pool* str_pool, struct str_view str_view) {
-    const struct str_view* found = str_view_set_find(&str_pool->str_view_set, &str_view);
-    return found ? found->data : NULL;
+    return find_with_hash(str_pool, str_view, str_view_hash(hash_init(), &str_view));
 }
 
 const char* str_pool_insert(struct str_pool* str_pool, const char* str) {
@@ -38,13 +145,163 @@ const char* str_pool_insert(struct str_pool* str_pool, const char* str) {
 }
 
 const char* str_pool_insert_view(struct str_pool* str_pool, struct str_view str_view) {
-    const struct str_view* found = str_view_set_find(&str_pool->str_view_set, &str_view);
+    uint32_t hash = str_view_hash(hash_init(), &str_view);
+    const char* found = find_with_hash(str_pool, str_view, hash);
     if (found)
-        return found->data;
+        return found;
 
-    char* data = mem_pool_alloc(str_pool->mem_pool, str_view.length + 1, 1);
+    assert(str_view.length <= UINT32_MAX);
+    assert(str_pool_size(str_pool) < STR_POOL_INVALID_ID);
+    struct str_pool_header* header = mem_pool_alloc(str_pool->mem_pool,
+        sizeof(struct str_pool_header) + str_view.length + 1, alignof(struct str_pool_header));
+    header->hash = hash;
+    header->length = (uint32_t)str_view.length;
+    header->id = str_pool->first_id + (uint32_t)str_pool->strs.elem_count;
+    char* data = (char*)(header + 1);
     xmemcpy(data, str_view.data, str_view.length);
     data[str_view.length] = 0;
-    str_view_set_insert(&str_pool->str_view_set, &(struct str_view) { .data = data, .length = str_view.length });
+    str_set_insert_with_hash(&str_pool->str_set, &(const char*) { data }, hash);
+    str_vec_push(&str_pool->strs, &(const char*) { data });
     return data;
 }
+
+size_t str_pool_size(const struct str_pool* str_pool) {
+    return str_pool->first_id + str_pool->strs.elem_count;
+}
+
+const char* str_pool_from_id(const struct str_pool* str_pool, uint32_t id) {
+    assert(id < str_pool_size(str_pool));
+    if (id < str_pool->first_id)
+        return snapshot_str(str_pool->snapshot, str_pool->snapshot->ids[id]);
+    return str_pool->strs.elems[id - str_pool->first_id];
+}
+
+static inline size_t align_up(size_t offset, size_t align) {
+    return (offset + align - 1) / align * align;
+}
+
+bool str_pool_save(const struct str_pool* str_pool, const char* file_name) {
+    size_t str_count = str_pool_size(str_pool);
+    size_t bucket_count = STR_POOL_SNAPSHOT_MIN_BUCKETS;
+    while (bucket_count < str_count * 2)
+        bucket_count *= 2;
+
+    struct str_pool_snapshot_header header = {
+        .magic = STR_POOL_SNAPSHOT_MAGIC,
+        .byte_order = STR_POOL_SNAPSHOT_BYTE_ORDER,
+        .str_count = (uint32_t)str_count,
+        .bucket_count = (uint32_t)bucket_count,
+        .bucket_shift = hash_table_compute_bucket_shift(bucket_count)
+    };
+    header.ids_offset = align_up(sizeof(header), alignof(uint64_t));
+    header.buckets_offset = align_up(header.ids_offset + str_count * sizeof(uint32_t), alignof(uint64_t));
+    header.data_offset = align_up(header.buckets_offset + bucket_count * sizeof(struct str_pool_snapshot_bucket), alignof(uint64_t));
+
+    uint32_t* ids = xmalloc(sizeof(uint32_t) * (str_count + 1));
+    struct str_pool_snapshot_bucket* buckets = xmalloc(sizeof(struct str_pool_snapshot_bucket) * bucket_count);
+    memset(buckets, 0xFF, sizeof(struct str_pool_snapshot_bucket) * bucket_count);
+    size_t data_size = 0;
+    for (size_t i = 0; i < str_count; ++i) {
+        const char* str = str_pool_from_id(str_pool, (uint32_t)i);
+        if (!str || data_size >= STR_POOL_SNAPSHOT_EMPTY_BUCKET) {
+            free(ids);
+            free(buckets);
+            return false;
+        }
+        ids[i] = (uint32_t)data_size;
+        size_t idx = snapshot_first_bucket(&header, str_pool_hash(str));
+        while (buckets[idx].offset != STR_POOL_SNAPSHOT_EMPTY_BUCKET)
+            idx = (idx + 1) & (bucket_count - 1);
+        buckets[idx] = (struct str_pool_snapshot_bucket) { .hash = str_pool_hash(str), .offset = ids[i] };
+        data_size = align_up(data_size + sizeof(struct str_pool_header) + str_pool_length(str) + 1, alignof(struct str_pool_header));
+    }
+    header.size = header.data_offset + data_size;
+
+    // The file is written under a temporary name and then renamed, so that existing mappings of the
+    // file, such as the snapshot this pool may have been created from, remain valid.
+    size_t file_name_length = strlen(file_name);
+    char* tmp_file_name = xmalloc(file_name_length + 5);
+    xmemcpy(tmp_file_name, file_name, file_name_length);
+    xmemcpy(tmp_file_name + file_name_length, ".tmp", 5);
+    FILE* file = fopen(tmp_file_name, "wb");
+    bool ok = file != NULL;
+    static const char padding[alignof(uint64_t)] = {};
+    if (ok) {
+        ok &= fwrite(&header, sizeof(header), 1, file) == 1;
+        ok &= fwrite(padding, 1, header.ids_offset - sizeof(header), file) == header.ids_offset - sizeof(header);
+        ok &= fwrite(ids, sizeof(uint32_t), str_count, file) == str_count;
+        size_t ids_end = header.ids_offset + str_count * sizeof(uint32_t);
+        ok &= fwrite(padding, 1, header.buckets_offset - ids_end, file) == header.buckets_offset - ids_end;
+        ok &= fwrite(buckets, sizeof(struct str_pool_snapshot_bucket), bucket_count, file) == bucket_count;
+        for (size_t i = 0; i < str_count && ok; ++i) {
+            const char* str = str_pool_from_id(str_pool, (uint32_t)i);
+            struct str_pool_header str_header = *str_pool_header(str);
+            str_header.id = (uint32_t)i;
+            size_t size = sizeof(struct str_pool_header) + str_header.length + 1;
+            size_t padding_size = align_up(size, alignof(struct str_pool_header)) - size;
+            ok &= fwrite(&str_header, sizeof(str_header), 1, file) == 1;
+            ok &= fwrite(str, 1, str_header.length + 1, file) == str_header.length + 1;
+            ok &= fwrite(padding, 1, padding_size, file) == padding_size;
+        }
+        ok &= fclose(file) == 0;
+        ok = ok && rename(tmp_file_name, file_name) == 0;
+        if (!ok)
+            remove(tmp_file_name);
+    }
+    free(tmp_file_name);
+    free(ids);
+    free(buckets);
+    return ok;
+}
+
+struct str_pool_snapshot* str_pool_snapshot_open(const char* file_name) {
+    struct mapped_file mapped_file;
+    if (!map_file(file_name, &mapped_file))
+        return NULL;
+
+    // The header and the position of the tables are checked here, while strings are checked when
+    // they are accessed. Offsets are compared to the size first, so that the sums cannot overflow.
+    const struct str_pool_snapshot_header* header = (const struct str_pool_snapshot_header*)mapped_file.data;
+    if (mapped_file.size < sizeof(struct str_pool_snapshot_header) ||
+        memcmp(header->magic, STR_POOL_SNAPSHOT_MAGIC, sizeof(header->magic)) ||
+        header->byte_order != STR_POOL_SNAPSHOT_BYTE_ORDER ||
+        header->size != mapped_file.size ||
+        header->bucket_count < STR_POOL_SNAPSHOT_MIN_BUCKETS ||
+        (header->bucket_count & (header->bucket_count - 1)) != 0 ||
+        header->bucket_shift != hash_table_compute_bucket_shift(header->bucket_count) ||
+        (header->ids_offset | header->buckets_offset | header->data_offset) % alignof(uint64_t) != 0 ||
+        header->str_count >= header->bucket_count ||
+        header->ids_offset < sizeof(struct str_pool_snapshot_header) ||
+        header->ids_offset > header->size ||
+        header->buckets_offset > header->size ||
+        header->ids_offset + header->str_count * sizeof(uint32_t) > header->buckets_offset ||
+        header->buckets_offset + header->bucket_count * sizeof(struct str_pool_snapshot_bucket) > header->data_offset ||
+        header->data_offset > header->size)
+    {
+        unmap_file(&mapped_file);
+        return NULL;
+    }
+
+    struct str_pool_snapshot* snapshot = xmalloc(sizeof(struct str_pool_snapshot));
+    *snapshot = (struct str_pool_snapshot) {
+        .mapped_file = mapped_file,
+        .header = header,
+        .ids = (const uint32_t*)(mapped_file.data + header->ids_offset),
+        .buckets = (const struct str_pool_snapshot_bucket*)(mapped_file.data + header->buckets_offset),
+        .data = mapped_file.data + header->data_offset
+    };
+    return snapshot;
+}
+
+void str_pool_snapshot_close(struct str_pool_snapshot* snapshot) {
+    unmap_file(&snapshot->mapped_file);
+    free(snapshot);
+}
+
+size_t str_pool_snapshot_size(const struct str_pool_snapshot* snapshot) {
+    return snapshot->header->str_count;
+}
+
+const char* str_pool_snapshot_find_view(const struct str_pool_snapshot* snapshot, struct str_view str_view) {
+    return snapshot_find(snapshot, str_view, str_view_hash(hash_init(), &str_view));
+}
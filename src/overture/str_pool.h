@@ -2,18 +2,52 @@
 
 #include "str.h"
 
+#include <stdint.h>
+
 /// @file
 ///
 /// String pool data structure. In this data structure, strings are stored in a hash set so that they
 /// can be compared by their address, and such that inserting twice the same string yields the same
 /// pointer.
+///
+/// Every string of a pool is preceded in memory by a header that stores its length and hash (see
+/// @ref str_pool_header). Thus, the length and hash of a string returned by a pool can be obtained
+/// in constant time, and maps or sets whose keys are strings of a pool can use
+/// @ref str_pool_hash_key as a hash function and compare keys by address.
+///
+/// Strings are also numbered in insertion order, starting from 0: The id of a string is stored in
+/// its header, and @ref str_pool_from_id returns the string that has a given id. Since ids are
+/// dense, they can be used to index plain arrays instead of maps keyed by strings.
+///
+/// A string pool can be saved to a file with @ref str_pool_save, which writes its strings along
+/// with a hash index. That file can later be opened with @ref str_pool_snapshot_open, which maps it
+/// in memory and searches it in place, without any parsing. A snapshot is read-only, but a string
+/// pool created on top of it with @ref str_pool_create_with_snapshot finds strings in the snapshot
+/// first, and inserts new strings in memory, numbering them after those of the snapshot. Snapshots
+/// use the byte order of the machine that wrote them, and are rejected on other machines.
+
+/// Id stored in the header of strings that do not have one, such as the strings of a concurrent
+/// string pool.
+#define STR_POOL_INVALID_ID UINT32_MAX
 
 struct str_pool;
+struct str_pool_snapshot;
 struct mem_pool;
 
+/// Header stored in memory right before the characters of every string of a string pool.
+struct str_pool_header {
+    uint32_t hash;      ///< Hash of the string, as computed by @ref str_view_hash from @ref hash_init.
+    uint32_t length;    ///< Length of the string, excluding the terminating `NULL` character.
+    uint32_t id;        ///< Position of the string in insertion order, or @ref STR_POOL_INVALID_ID.
+};
+
 /// Creates an empty string pool.
 [[nodiscard]] struct str_pool* str_pool_create(struct mem_pool*);
 
+/// Creates a string pool that contains the strings of the given snapshot, which must outlive it.
+/// @param snapshot A snapshot, or `NULL` to create an empty string pool.
+[[nodiscard]] struct str_pool* str_pool_create_with_snapshot(struct mem_pool*, const struct str_pool_snapshot* snapshot);
+
 /// Destroys a string pool.
 void str_pool_destroy(struct str_pool*);
 
@@ -32,3 +66,60 @@ const char* str_pool_insert(struct str_pool*, const char*);
 /// Inserts a string view in a string pool.
 /// @return A `NULL`-terminated string allocated from the string pool.
 const char* str_pool_insert_view(struct str_pool*, struct str_view);
+
+/// @return The number of strings in a string pool, which is also the id of the next inserted string.
+[[nodiscard]] size_t str_pool_size(const struct str_pool*);
+
+/// @return The string of the string pool that has the given id, or `NULL` if that string comes from
+///   a snapshot whose file is corrupted.
+[[nodiscard]] const char* str_pool_from_id(const struct str_pool*, uint32_t id);
+
+/// Saves the strings of a string pool to a file, along with their ids and a hash index.
+/// @return `true` on success, otherwise `false`.
+[[nodiscard]] bool str_pool_save(const struct str_pool*, const char* file_name);
+
+/// Opens a snapshot of a string pool that was saved with @ref str_pool_save.
+/// @return The snapshot, or `NULL` if the file cannot be opened or is not a valid snapshot.
+[[nodiscard]] struct str_pool_snapshot* str_pool_snapshot_open(const char* file_name);
+
+/// Closes a snapshot of a string pool. Strings obtained from the snapshot are invalid afterwards.
+void str_pool_snapshot_close(struct str_pool_snapshot*);
+
+/// @return The number of strings in a snapshot of a string pool.
+[[nodiscard]] size_t str_pool_snapshot_size(const struct str_pool_snapshot*);
+
+/// Finds a string view in a snapshot of a string pool.
+/// @return If it exists, the `NULL`-terminated string in the snapshot that is equal to the argument, or NULL otherwise.
+const char* str_pool_snapshot_find_view(const struct str_pool_snapshot*, struct str_view);
+
+/// @return The header of a string that was returned by a string pool.
+[[nodiscard]] static inline const struct str_pool_header* str_pool_header(const char* str) {
+    return (const struct str_pool_header*)str - 1;
+}
+
+/// @return The hash of a string that was returned by a string pool.
+[[nodiscard]] static inline uint32_t str_pool_hash(const char* str) {
+    return str_pool_header(str)->hash;
+}
+
+/// @return The length of a string that was returned by a string pool.
+[[nodiscard]] static inline size_t str_pool_length(const char* str) {
+    return str_pool_header(str)->length;
+}
+
+/// @return The id of a string that was returned by a string pool.
+[[nodiscard]] static inline uint32_t str_pool_id(const char* str) {
+    return str_pool_header(str)->id;
+}
+
+/// @return A view of a string that was returned by a string pool.
+[[nodiscard]] static inline struct str_view str_pool_view(const char* str) {
+    return (struct str_view) { .data = str, .length = str_pool_length(str) };
+}
+
+/// Hash function for maps or sets whose keys are strings of a string pool, which only hashes the
+/// hash stored in the header of the string. Such keys can be compared by address, for instance with
+/// @ref MAP_DEFINE_TRIVIAL.
+[[nodiscard]] static inline uint32_t str_pool_hash_key(uint32_t h, const char* const* str) {
+    return hash_uint32(h, str_pool_hash(*str));
+}
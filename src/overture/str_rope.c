@@ -0,0 +1,215 @@
+#include "str_rope.h"
+#include "mem_pool.h"
+#include "mem.h"
+#include "vec.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdarg.h>
+#include <string.h>
+#include <limits.h>
+#include <errno.h>
+#include <assert.h>
+
+#if defined (__unix__) || (defined (__APPLE__) && defined (__MACH__))
+#include <sys/uio.h>
+#include <unistd.h>
+#define HAS_WRITEV
+#elif defined (_WIN32)
+#include <io.h>
+#define write _write
+#else
+#include <unistd.h>
+#endif
+
+#define MIN_CHUNK_CAPACITY 4096
+
+// Number of fragments passed to a single call to `writev`.
+#if defined (IOV_MAX) && IOV_MAX < 1024
+#define IOV_COUNT IOV_MAX
+#else
+#define IOV_COUNT 1024
+#endif
+
+VEC_DEFINE(fragment_vec, struct str_view, PRIVATE)
+VEC_DEFINE(owned_vec, char*, PRIVATE)
+
+struct str_rope {
+    struct fragment_vec fragments;
+    struct owned_vec owned;
+    struct mem_pool mem_pool;
+    char* chunk;
+    size_t chunk_size;
+    size_t chunk_capacity;
+    size_t length;
+};
+
+struct str_rope* str_rope_create(void) {
+    struct str_rope* rope = xmalloc(sizeof(struct str_rope));
+    *rope = (struct str_rope) {
+        .fragments = fragment_vec_create(),
+        .owned = owned_vec_create(),
+        .mem_pool = mem_pool_create()
+    };
+    return rope;
+}
+
+static void free_owned(struct str_rope* rope) {
+    VEC_FOREACH(char*, data, rope->owned) {
+        free(*data);
+    }
+}
+
+void str_rope_destroy(struct str_rope* rope) {
+    free_owned(rope);
+    fragment_vec_destroy(&rope->fragments);
+    owned_vec_destroy(&rope->owned);
+    mem_pool_destroy(&rope->mem_pool);
+    free(rope);
+}
+
+void str_rope_clear(struct str_rope* rope) {
+    free_owned(rope);
+    fragment_vec_clear(&rope->fragments);
+    owned_vec_clear(&rope->owned);
+    mem_pool_reset(&rope->mem_pool);
+    rope->chunk = NULL;
+    rope->chunk_size = rope->chunk_capacity = 0;
+    rope->length = 0;
+}
+
+size_t str_rope_length(const struct str_rope* rope) {
+    return rope->length;
+}
+
+size_t str_rope_fragment_count(const struct str_rope* rope) {
+    return rope->fragments.elem_count;
+}
+
+void str_rope_append_view(struct str_rope* rope, struct str_view view) {
+    if (view.length == 0)
+        return;
+    rope->length += view.length;
+    if (!fragment_vec_is_empty(&rope->fragments)) {
+        // Fragments that are contiguous in memory are merged, which is always the case for
+        // consecutive copies in the same chunk.
+        struct str_view* last = fragment_vec_last(&rope->fragments);
+        if (last->data + last->length == view.data) {
+            last->length += view.length;
+            return;
+        }
+    }
+    fragment_vec_push(&rope->fragments, &view);
+}
+
+void str_rope_append_str(struct str_rope* rope, struct str* str) {
+    if (str->data)
+        owned_vec_push(&rope->owned, &str->data);
+    str_rope_append_view(rope, str_release(str));
+}
+
+static char* reserve(struct str_rope* rope, size_t size) {
+    if (rope->chunk_size + size > rope->chunk_capacity) {
+        rope->chunk_capacity = size > MIN_CHUNK_CAPACITY ? size : MIN_CHUNK_CAPACITY;
+        rope->chunk = mem_pool_alloc(&rope->mem_pool, rope->chunk_capacity, 1);
+        rope->chunk_size = 0;
+    }
+    return rope->chunk + rope->chunk_size;
+}
+
+static void commit(struct str_rope* rope, size_t size) {
+    str_rope_append_view(rope, (struct str_view) { .data = rope->chunk + rope->chunk_size, .length = size });
+    rope->chunk_size += size;
+}
+
+void str_rope_append_copy(struct str_rope* rope, struct str_view view) {
+    if (view.length == 0)
+        return;
+    xmemcpy(reserve(rope, view.length), view.data, view.length);
+    commit(rope, view.length);
+}
+
+void str_rope_printf(struct str_rope* rope, const char* fmt, ...) {
+    size_t remaining_size = rope->chunk_capacity - rope->chunk_size;
+
+    va_list args;
+    va_start(args, fmt);
+    int req_size = vsnprintf(rope->chunk ? rope->chunk + rope->chunk_size : NULL, remaining_size, fmt, args);
+    va_end(args);
+    assert(req_size >= 0);
+
+    if ((size_t)req_size >= remaining_size) {
+        char* data = reserve(rope, req_size + 1);
+
+        va_start(args, fmt);
+        [[maybe_unused]] int new_req_size = vsnprintf(data, req_size + 1, fmt, args);
+        va_end(args);
+        assert(new_req_size == req_size);
+    }
+    commit(rope, req_size);
+}
+
+void str_rope_flatten(const struct str_rope* rope, struct str* str) {
+    str_grow(str, rope->length);
+    VEC_FOREACH(const struct str_view, fragment, rope->fragments) {
+        xmemcpy(str->data + str->length, fragment->data, fragment->length);
+        str->length += fragment->length;
+    }
+}
+
+#ifdef HAS_WRITEV
+bool str_rope_write(const struct str_rope* rope, int fd) {
+    const struct str_view* fragments = rope->fragments.elems;
+    size_t fragment_count = rope->fragments.elem_count;
+    size_t first = 0;
+    size_t offset = 0;
+    while (first < fragment_count) {
+        struct iovec iovs[IOV_COUNT];
+        int iov_count = 0;
+        for (size_t i = first; i < fragment_count && iov_count < IOV_COUNT; ++i, ++iov_count) {
+            size_t skip = i == first ? offset : 0;
+            iovs[iov_count] = (struct iovec) {
+                .iov_base = (void*)(fragments[i].data + skip),
+                .iov_len = fragments[i].length - skip
+            };
+        }
+
+        ssize_t written = writev(fd, iovs, iov_count);
+        if (written < 0 && errno == EINTR)
+            continue;
+        if (written <= 0)
+            return false;
+
+        // Skip the fragments that have been entirely written, and remember how much of the last one
+        // has been written, in case of a partial write.
+        size_t left = written;
+        while (left > 0) {
+            size_t fragment_left = fragments[first].length - offset;
+            if (left < fragment_left) {
+                offset += left;
+                break;
+            }
+            left -= fragment_left;
+            offset = 0;
+            first++;
+        }
+    }
+    return true;
+}
+#else
+bool str_rope_write(const struct str_rope* rope, int fd) {
+    VEC_FOREACH(const struct str_view, fragment, rope->fragments) {
+        size_t offset = 0;
+        while (offset < fragment->length) {
+            size_t to_write = fragment->length - offset;
+            int written = write(fd, fragment->data + offset, to_write > INT_MAX ? INT_MAX : (unsigned)to_write);
+            if (written < 0 && errno == EINTR)
+                continue;
+            if (written <= 0)
+                return false;
+            offset += written;
+        }
+    }
+    return true;
+}
+#endif
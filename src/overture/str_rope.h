@@ -0,0 +1,58 @@
+#pragma once
+
+#include "str.h"
+
+#include <stddef.h>
+#include <stdbool.h>
+
+/// @file
+///
+/// String rope, that is, a string builder that records a list of fragments instead of copying them
+/// into a single, contiguous buffer. Building a large string with @ref str_append reallocates and
+/// copies the buffer every time it grows; a rope never moves what it has recorded, and only copies
+/// each fragment once, when it is written to a file with @ref str_rope_write (which uses `writev`
+/// where available), or flattened into a contiguous string with @ref str_rope_flatten.
+///
+/// Fragments are either borrowed (@ref str_rope_append_view), in which case they must outlive the
+/// rope, owned (@ref str_rope_append_str), in which case the rope takes over the buffer of the given
+/// string, or copied into chunks owned by the rope (@ref str_rope_append_copy, @ref str_rope_printf).
+/// Consecutive copies are packed in the same chunk, and form a single fragment.
+
+struct str_rope;
+
+/// Creates an empty string rope.
+[[nodiscard]] struct str_rope* str_rope_create(void);
+
+/// Destroys a string rope, along with the fragments that it owns.
+void str_rope_destroy(struct str_rope*);
+
+/// Removes all the fragments of a string rope. Chunks owned by the rope are kept for later copies.
+void str_rope_clear(struct str_rope*);
+
+/// @return The length of the string represented by the rope, in bytes.
+[[nodiscard]] size_t str_rope_length(const struct str_rope*);
+
+/// @return The number of fragments in the rope.
+[[nodiscard]] size_t str_rope_fragment_count(const struct str_rope*);
+
+/// Appends a fragment to a rope without copying it. The data of the fragment must remain valid
+/// until the rope is destroyed or cleared.
+void str_rope_append_view(struct str_rope*, struct str_view);
+
+/// Appends the contents of a string to a rope without copying it, and resets that string to an empty
+/// state. The buffer of the string is freed with the rope.
+void str_rope_append_str(struct str_rope*, struct str*);
+
+/// Appends a copy of the given data to a rope.
+void str_rope_append_copy(struct str_rope*, struct str_view);
+
+/// Appends formatted text to a rope.
+[[gnu::format(printf, 2, 3)]]
+void str_rope_printf(struct str_rope*, const char* fmt, ...);
+
+/// Appends the contents of a rope at the end of a string, growing the string only once.
+void str_rope_flatten(const struct str_rope*, struct str*);
+
+/// Writes the contents of a rope to a file descriptor, with as few system calls as possible.
+/// @return `true` on success, otherwise `false`.
+[[nodiscard]] bool str_rope_write(const struct str_rope*, int fd);
@@ -0,0 +1,93 @@
+#include <overture/test.h>
+#include <overture/log.h>
+#include <overture/mem_stream.h>
+#include <overture/thread_pool.h>
+
+#include <stdio.h>
+#include <inttypes.h>
+#include <string.h>
+
+struct log_work_item {
+    struct work_item item;
+    struct log* logs;
+    uint32_t first, last;
+};
+
+static void log_work_func(struct work_item* item, size_t thread_idx) {
+    struct log_work_item* log_item = (struct log_work_item*)item;
+    struct log* log = &log_item->logs[thread_idx];
+    for (uint32_t i = log_item->first; i < log_item->last; ++i) {
+        struct file_loc loc = {
+            .displayed_file_name = "file",
+            .displayed_line = i + 1,
+            .begin = { .row = i + 1, .col = 1 },
+            .end = { .row = i + 1, .col = 2 }
+        };
+        log_msg(i % 2 ? MSG_ERROR : MSG_WARN, log, &loc, "%"PRIu32, i);
+        log_note(log, NULL, "%"PRIu32, i);
+    }
+}
+
+static char* run_log_workers(size_t thread_count, size_t max_errors) {
+    enum { n = 2000, item_count = 16 };
+
+    struct mem_stream mem_stream;
+    mem_stream_init(&mem_stream);
+    struct log log = {
+        .file = mem_stream.file,
+        .disable_colors = true,
+        .max_errors = max_errors,
+        .max_warns = SIZE_MAX,
+        .defer_msgs = true
+    };
+    struct log children[thread_count];
+    for (size_t i = 0; i < thread_count; ++i)
+        children[i] = log_create_child(&log);
+
+    struct log_work_item items[item_count];
+    for (size_t i = 0; i < item_count; ++i) {
+        items[i] = (struct log_work_item) {
+            .item.work_func = log_work_func,
+            .item.next = i + 1 < item_count ? &items[i + 1].item : NULL,
+            .logs = children,
+            .first = (uint32_t)(i * n / item_count),
+            .last = (uint32_t)((i + 1) * n / item_count)
+        };
+    }
+
+    struct thread_pool* thread_pool = thread_pool_create(thread_count);
+    thread_pool_submit(thread_pool, &items[0].item, &items[item_count - 1].item);
+    thread_pool_wait(thread_pool, 0);
+    thread_pool_destroy(thread_pool);
+
+    log_merge(&log, children, thread_count);
+    log_flush(&log);
+    for (size_t i = 0; i < thread_count; ++i)
+        log_destroy(&children[i]);
+    if (log.error_count != n / 2 || log.warn_count != n / 2) {
+        log_destroy(&log);
+        free(mem_stream_release(&mem_stream));
+        return NULL;
+    }
+    log_destroy(&log);
+    return mem_stream_release(&mem_stream);
+}
+
+TEST(concurrent_log) {
+    // Without limits, the output does not depend on the number of threads or their scheduling.
+    char* single = run_log_workers(1, SIZE_MAX);
+    char* multi = run_log_workers(4, SIZE_MAX);
+    REQUIRE(single && multi);
+    REQUIRE(strcmp(single, multi) == 0);
+    free(single);
+    free(multi);
+
+    // Limits apply to all threads together.
+    char* limited = run_log_workers(4, 10);
+    REQUIRE(limited);
+    size_t error_count = 0;
+    for (const char* p = limited; (p = strstr(p, "error: ")); ++p)
+        error_count++;
+    REQUIRE(error_count == 10);
+    free(limited);
+}
@@ -0,0 +1,97 @@
+#include <overture/test.h>
+#include <overture/concurrent_map.h>
+#include <overture/concurrent_set.h>
+#include <overture/thread_pool.h>
+
+#include <stdatomic.h>
+
+static inline uint32_t hash_int(uint32_t h, const int* i) { return hash_uint32(h, *i); }
+static inline bool is_int_equal(const int* i, const int* j) { return *i == *j; }
+
+CONCURRENT_MAP_DEFINE(concurrent_int_map, int, int, hash_int, is_int_equal, PRIVATE)
+CONCURRENT_SET_DEFINE(concurrent_int_set, int, hash_int, is_int_equal, PRIVATE)
+
+struct insert_work_item {
+    struct work_item item;
+    struct concurrent_int_map* map;
+    int first, last;
+    atomic_size_t* inserted_count;
+    atomic_bool* has_missing_val;
+};
+
+static void insert_work_func(struct work_item* item, size_t) {
+    struct insert_work_item* insert_item = (struct insert_work_item*)item;
+    size_t inserted_count = 0;
+    for (int i = insert_item->first; i < insert_item->last; ++i) {
+        int val = i * 2;
+        if (concurrent_int_map_insert(insert_item->map, &i, &val))
+            inserted_count++;
+        const int* found = concurrent_int_map_find(insert_item->map, &i);
+        if (!found || *found != val)
+            atomic_store(insert_item->has_missing_val, true);
+    }
+    atomic_fetch_add(insert_item->inserted_count, inserted_count);
+}
+
+TEST(concurrent_map) {
+    const int n = 100000;
+    static const size_t item_count = 8;
+    struct concurrent_int_map map = concurrent_int_map_create();
+    atomic_size_t inserted_count = 0;
+    atomic_bool has_missing_val = false;
+
+    // Work items overlap, so that several threads try to insert the same keys.
+    struct insert_work_item items[item_count];
+    for (size_t i = 0; i < item_count; ++i) {
+        items[i] = (struct insert_work_item) {
+            .item.work_func = insert_work_func,
+            .item.next = i + 1 < item_count ? &items[i + 1].item : NULL,
+            .map = &map,
+            .first = (int)(i * n / item_count) / 2,
+            .last = (int)((i + 1) * n / item_count),
+            .inserted_count = &inserted_count,
+            .has_missing_val = &has_missing_val
+        };
+    }
+
+    struct thread_pool* thread_pool = thread_pool_create(4);
+    thread_pool_submit(thread_pool, &items[0].item, &items[item_count - 1].item);
+    thread_pool_wait(thread_pool, 0);
+    thread_pool_destroy(thread_pool);
+
+    REQUIRE(!atomic_load(&has_missing_val));
+    REQUIRE(atomic_load(&inserted_count) == (size_t)n);
+    REQUIRE(concurrent_int_map_size(&map) == (size_t)n);
+    for (int i = 0; i < n; ++i) {
+        REQUIRE(concurrent_int_map_find(&map, &i));
+        REQUIRE(*concurrent_int_map_find(&map, &i) == i * 2);
+    }
+    int i = n;
+    REQUIRE(!concurrent_int_map_find(&map, &i));
+
+    size_t count = 0;
+    CONCURRENT_MAP_FOREACH(int, key, int, val, map) {
+        REQUIRE(*val == *key * 2);
+        count++;
+    }
+    REQUIRE(count == (size_t)n);
+    concurrent_int_map_destroy(&map);
+}
+
+TEST(concurrent_set) {
+    const int n = 1000;
+    struct concurrent_int_set set = concurrent_int_set_create();
+    for (int i = 0; i < n; ++i)
+        REQUIRE(concurrent_int_set_insert(&set, &i));
+    for (int i = 0; i < n; ++i) {
+        REQUIRE(!concurrent_int_set_insert(&set, &i));
+        REQUIRE(*concurrent_int_set_find(&set, &i) == i);
+    }
+    int sum = 0;
+    CONCURRENT_SET_FOREACH(int, elem, set) {
+        sum += *elem;
+    }
+    REQUIRE(sum == n * (n - 1) / 2);
+    REQUIRE(concurrent_int_set_size(&set) == (size_t)n);
+    concurrent_int_set_destroy(&set);
+}
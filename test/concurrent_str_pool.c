@@ -0,0 +1,74 @@
+#include <overture/test.h>
+#include <overture/concurrent_str_pool.h>
+#include <overture/mem_pool.h>
+#include <overture/thread_pool.h>
+
+#include <stdatomic.h>
+#include <stdio.h>
+#include <string.h>
+
+struct intern_work_item {
+    struct work_item item;
+    struct concurrent_str_pool* str_pool;
+    struct mem_pool mem_pool;
+    _Atomic(const char*)* strs;
+    int first, last;
+    atomic_bool* has_mismatch;
+};
+
+static void intern_work_func(struct work_item* item, size_t) {
+    struct intern_work_item* intern_item = (struct intern_work_item*)item;
+    for (int i = intern_item->first; i < intern_item->last; ++i) {
+        char buf[16];
+        snprintf(buf, sizeof(buf), "str%d", i);
+        const char* str = concurrent_str_pool_insert(intern_item->str_pool, &intern_item->mem_pool, buf);
+        // Every thread must obtain the same pointer for the same string.
+        const char* expected = NULL;
+        if (!atomic_compare_exchange_strong(&intern_item->strs[i], &expected, str) && expected != str)
+            atomic_store(intern_item->has_mismatch, true);
+        if (strcmp(str, buf) || str_pool_length(str) != strlen(buf))
+            atomic_store(intern_item->has_mismatch, true);
+    }
+}
+
+TEST(concurrent_str_pool) {
+    enum { n = 20000, item_count = 8 };
+    static _Atomic(const char*) strs[n];
+    for (int i = 0; i < n; ++i)
+        atomic_init(&strs[i], NULL);
+    atomic_bool has_mismatch = false;
+    struct concurrent_str_pool* str_pool = concurrent_str_pool_create();
+
+    // Work items overlap, so that several threads try to insert the same strings.
+    struct intern_work_item items[item_count];
+    for (size_t i = 0; i < item_count; ++i) {
+        items[i] = (struct intern_work_item) {
+            .item.work_func = intern_work_func,
+            .item.next = i + 1 < item_count ? &items[i + 1].item : NULL,
+            .str_pool = str_pool,
+            .mem_pool = mem_pool_create(),
+            .strs = strs,
+            .first = (int)(i * n / item_count) / 2,
+            .last = (int)((i + 1) * n / item_count),
+            .has_mismatch = &has_mismatch
+        };
+    }
+
+    struct thread_pool* thread_pool = thread_pool_create(4);
+    thread_pool_submit(thread_pool, &items[0].item, &items[item_count - 1].item);
+    thread_pool_wait(thread_pool, 0);
+    thread_pool_destroy(thread_pool);
+
+    REQUIRE(!atomic_load(&has_mismatch));
+    REQUIRE(concurrent_str_pool_size(str_pool) == (size_t)n);
+    for (int i = 0; i < n; ++i) {
+        char buf[16];
+        snprintf(buf, sizeof(buf), "str%d", i);
+        REQUIRE(concurrent_str_pool_find(str_pool, buf) == atomic_load(&strs[i]));
+    }
+    REQUIRE(!concurrent_str_pool_find(str_pool, "str"));
+
+    concurrent_str_pool_destroy(str_pool);
+    for (size_t i = 0; i < item_count; ++i)
+        mem_pool_destroy(&items[i].mem_pool);
+}
@@ -21,4 +21,32 @@ TEST(file) {
     REQUIRE(file_size == strlen(contents));
     REQUIRE(strcmp(buf, contents) == 0);
     free(buf);
+
+    struct mapped_file mapped_file;
+    REQUIRE(map_file(file_name, &mapped_file));
+    REQUIRE(mapped_file.size == strlen(contents));
+    REQUIRE(!memcmp(mapped_file.data, contents, mapped_file.size));
+    unmap_file(&mapped_file);
+    REQUIRE(!map_file("a_file_that_does_not_exist.txt", &mapped_file));
+}
+
+static bool is_view_equal_to(struct str_view view, const char* str) {
+    return view.length == strlen(str) && !memcmp(view.data, str, view.length);
+}
+
+TEST(split_path) {
+    struct file_path path = split_path(STR_VIEW("a/b/c.tar.gz"));
+    REQUIRE(is_view_equal_to(path.dir_name, "a/b"));
+    REQUIRE(is_view_equal_to(path.base_name, "c"));
+    REQUIRE(is_view_equal_to(path.ext, ".tar.gz"));
+
+    path = split_path(STR_VIEW("file.c"));
+    REQUIRE(is_view_equal_to(path.dir_name, ""));
+    REQUIRE(is_view_equal_to(path.base_name, "file"));
+    REQUIRE(is_view_equal_to(path.ext, ".c"));
+
+    path = split_path(STR_VIEW("dir.d/file"));
+    REQUIRE(is_view_equal_to(path.dir_name, "dir.d"));
+    REQUIRE(is_view_equal_to(path.base_name, "file"));
+    REQUIRE(is_view_equal_to(path.ext, ""));
 }
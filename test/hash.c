@@ -0,0 +1,79 @@
+#include <overture/test.h>
+#include <overture/hash.h>
+#include <overture/minstd.h>
+
+#include <string.h>
+
+TEST(hash_bytes) {
+    const char* str = "hello, world";
+    REQUIRE(hash_bytes(hash_init(), str, strlen(str)) == hash_string(hash_init(), str));
+    REQUIRE(hash_fast_bytes(hash_init(), str, strlen(str)) == hash_fast_string(hash_init(), str));
+    REQUIRE(hash_bytes(hash_init(), NULL, 0) == hash_init());
+}
+
+TEST(hash_fast) {
+    enum { max_size = 4096 };
+    static uint8_t bytes[max_size + 8];
+    uint32_t state = 1;
+    for (size_t i = 0; i < sizeof(bytes); ++i)
+        bytes[i] = minstd_gen(&state);
+
+    for (size_t size = 0; size <= max_size; size += size < 300 ? 1 : 97) {
+        // The result must not depend on the alignment of the data.
+        uint32_t h = hash_fast_bytes(hash_init(), bytes, size);
+        uint8_t copy[max_size + 1];
+        memcpy(copy + 1, bytes, size);
+        REQUIRE(hash_fast_bytes(hash_init(), copy + 1, size) == h);
+
+        // Flipping a bit, changing the size, or changing the initial value must change the result.
+        if (size > 0) {
+            copy[1 + size * 7 / 13] ^= 0x10;
+            REQUIRE(hash_fast_bytes(hash_init(), copy + 1, size) != h);
+        }
+        REQUIRE(hash_fast_bytes(hash_init(), bytes, size + 1) != h);
+        REQUIRE(hash_fast_bytes(hash_init() + 1, bytes, size) != h);
+    }
+
+    // Stripes that are swapped must produce different results.
+    uint8_t swapped[max_size];
+    memcpy(swapped, bytes + HASH_FAST_STRIPE_SIZE, HASH_FAST_STRIPE_SIZE);
+    memcpy(swapped + HASH_FAST_STRIPE_SIZE, bytes, HASH_FAST_STRIPE_SIZE);
+    memcpy(swapped + 2 * HASH_FAST_STRIPE_SIZE, bytes + 2 * HASH_FAST_STRIPE_SIZE, max_size - 2 * HASH_FAST_STRIPE_SIZE);
+    REQUIRE(hash_fast_bytes(hash_init(), swapped, max_size) != hash_fast_bytes(hash_init(), bytes, max_size));
+
+    REQUIRE(hash_fast_uint64(hash_init(), 1) != hash_fast_uint64(hash_init(), 2));
+    REQUIRE(hash_fast_uint64(hash_init(), 1) != hash_fast_uint64(hash_fast_uint64(hash_init(), 1), 1));
+}
+
+TEST(hash_sip) {
+    const char* str = "hello, world";
+    REQUIRE(hash_sip_bytes(hash_init(), str, strlen(str)) == hash_sip_string(hash_init(), str));
+    uint8_t bytes[32] = {};
+    for (size_t size = 0; size < sizeof(bytes); ++size) {
+        uint32_t h = hash_sip_bytes(hash_init(), bytes, size);
+        REQUIRE(hash_sip_bytes(hash_init(), bytes, size + 1) != h);
+        REQUIRE(hash_sip_bytes(hash_init() + 1, bytes, size) != h);
+    }
+    uint32_t seed = hash_random_seed();
+    REQUIRE(hash_sip_uint64(seed, 1) != hash_sip_uint64(seed, 2));
+}
+
+TEST(hash_fast_accumulate) {
+    enum { stripe_count = 37 };
+    static uint8_t bytes[stripe_count * HASH_FAST_STRIPE_SIZE];
+    uint32_t state = 1;
+    for (size_t i = 0; i < sizeof(bytes); ++i)
+        bytes[i] = minstd_gen(&state);
+
+    // The vectorized implementation must produce the same results as the scalar one.
+    uint64_t acc[HASH_FAST_LANE_COUNT], keys[HASH_FAST_LANE_COUNT];
+    uint64_t ref_acc[HASH_FAST_LANE_COUNT], ref_keys[HASH_FAST_LANE_COUNT];
+    for (size_t j = 0; j < HASH_FAST_LANE_COUNT; ++j) {
+        acc[j] = ref_acc[j] = hash_fast_lane_keys[j] * (j + 1);
+        keys[j] = ref_keys[j] = hash_fast_lane_keys[j];
+    }
+    hash_fast_accumulate(acc, keys, bytes + 1, stripe_count - 1);
+    hash_fast_accumulate_scalar(ref_acc, ref_keys, bytes + 1, stripe_count - 1);
+    REQUIRE(!memcmp(acc, ref_acc, sizeof(acc)));
+    REQUIRE(!memcmp(keys, ref_keys, sizeof(keys)));
+}
@@ -0,0 +1,41 @@
+#include <overture/test.h>
+#include <overture/indexed_map.h>
+
+static inline uint32_t hash_int(uint32_t h, const int* i) { return hash_uint32(h, *i); }
+static inline bool is_int_equal(const int* i, const int* j) { return *i == *j; }
+
+INDEXED_MAP_DEFINE(indexed_int_map, int, int, hash_int, is_int_equal, PRIVATE)
+
+TEST(indexed_map) {
+    const int n = 1000;
+    struct indexed_int_map map = indexed_int_map_create();
+    for (int i = 0; i < n; ++i) {
+        int val = i * 2;
+        REQUIRE(indexed_int_map_insert(&map, &i, &val));
+        REQUIRE(!indexed_int_map_insert(&map, &i, &val));
+    }
+    int next_key = 0;
+    INDEXED_MAP_FOREACH(int, key, int, val, map) {
+        REQUIRE(*key == next_key++);
+        REQUIRE(*val == *key * 2);
+    }
+    REQUIRE(next_key == n);
+
+    for (int i = 0; i < n; i += 3)
+        REQUIRE(indexed_int_map_remove(&map, &i));
+    REQUIRE(!indexed_int_map_remove(&map, &(int) { 0 }));
+    for (int i = 0; i < n; ++i) {
+        const int* val = indexed_int_map_find(&map, &i);
+        REQUIRE(i % 3 == 0 ? !val : val && *val == i * 2);
+    }
+
+    size_t count = 0;
+    INDEXED_MAP_FOREACH(int, key, int, val, map) {
+        REQUIRE(*key % 3 != 0);
+        REQUIRE(*val == *key * 2);
+        count++;
+    }
+    REQUIRE(count == map.keys.elem_count);
+    REQUIRE(count == (size_t)(n - (n + 2) / 3));
+    indexed_int_map_destroy(&map);
+}
@@ -0,0 +1,31 @@
+#include <overture/test.h>
+#include <overture/line_reader.h>
+
+#include <stdio.h>
+#include <string.h>
+
+static bool is_line_equal_to(struct file_line line, const char* str) {
+    return line.is_valid && line.contents.length == strlen(str) && !memcmp(line.contents.data, str, line.contents.length);
+}
+
+TEST(line_reader) {
+    static const char* file_name = "the_line_file.txt";
+    FILE* file = fopen(file_name, "wb");
+    REQUIRE(file);
+    fputs("first\n\nthird\r\nlast", file);
+    fclose(file);
+
+    struct line_reader* line_reader = file_line_reader_create();
+    for (size_t i = 0; i < 2; ++i) {
+        REQUIRE(!line_reader->read_line(line_reader->data, file_name, 0).is_valid);
+        REQUIRE(is_line_equal_to(line_reader->read_line(line_reader->data, file_name, 4), "last"));
+        REQUIRE(is_line_equal_to(line_reader->read_line(line_reader->data, file_name, 1), "first"));
+        REQUIRE(is_line_equal_to(line_reader->read_line(line_reader->data, file_name, 2), ""));
+        REQUIRE(is_line_equal_to(line_reader->read_line(line_reader->data, file_name, 3), "third"));
+        REQUIRE(!line_reader->read_line(line_reader->data, file_name, 5).is_valid);
+    }
+    REQUIRE(!line_reader->read_line(line_reader->data, "a_file_that_does_not_exist.txt", 1).is_valid);
+    REQUIRE(!line_reader->read_line(line_reader->data, "a_file_that_does_not_exist.txt", 1).is_valid);
+    file_line_reader_destroy(line_reader);
+    remove(file_name);
+}
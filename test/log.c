@@ -85,4 +85,202 @@ TEST(log) {
 
     REQUIRE(strcmp(buf, result) == 0);
     free(buf);
+    log_destroy(&log);
+}
+
+TEST(log_deferred) {
+    struct mem_stream mem_stream;
+    mem_stream_init(&mem_stream);
+
+    struct line_reader line_reader = { .read_line = read_line };
+    struct log log = {
+        .file = mem_stream.file,
+        .disable_colors = true,
+        .max_warns = SIZE_MAX,
+        .max_errors = SIZE_MAX,
+        .line_reader = &line_reader,
+        .defer_msgs = true
+    };
+
+    struct source_pos begin = { .row = 2, .col = 2 };
+    struct source_pos end   = { .row = 2, .col = 3 };
+    log_warn(&log, &(struct file_loc) { .displayed_file_name = "b", .displayed_line = 1, .begin = begin, .end = end }, "%d", 1);
+    log_note(&log, NULL, "%d", 2);
+    log_error(&log, &(struct file_loc) { .displayed_file_name = "a", .displayed_line = 2, .begin = begin, .end = end }, "%d", 3);
+    log_error(&log, &(struct file_loc) { .displayed_file_name = "a", .displayed_line = 1, .begin = begin, .end = end }, "%d", 4);
+    log_error(&log, NULL, "%d", 5);
+    log_note(&log, NULL, "%d", 6);
+    log_warn(&log, &(struct file_loc) { .displayed_file_name = "a", .displayed_line = 1, .begin = begin, .end = end }, "%d", 7);
+    REQUIRE(log.deferred_msgs.elem_count == 5);
+    log_flush(&log);
+    REQUIRE(log.deferred_msgs.elem_count == 0);
+
+    char* buf = mem_stream_release(&mem_stream);
+    static const char* result =
+        "error: 5\n"
+        "note: 6\n"
+        "\n"
+        "error: 4\n"
+        "  in a(1:2 - 1:3)\n"
+        "   |\n"
+        " 1 | efgh\n"
+        "   | ^\n"
+        "\n"
+        "warning: 7\n"
+        "  in a(1:2 - 1:3)\n"
+        "   |\n"
+        " 1 | efgh\n"
+        "   | ^\n"
+        "\n"
+        "error: 3\n"
+        "  in a(2:2 - 2:3)\n"
+        "   |\n"
+        " 2 | efgh\n"
+        "   | ^\n"
+        "\n"
+        "warning: 1\n"
+        "  in b(1:2 - 1:3)\n"
+        "   |\n"
+        " 1 | efgh\n"
+        "   | ^\n"
+        "note: 2\n";
+    REQUIRE(strcmp(buf, result) == 0);
+    free(buf);
+    log_destroy(&log);
+}
+
+TEST(log_child) {
+    struct mem_stream mem_stream;
+    mem_stream_init(&mem_stream);
+
+    struct log log = {
+        .file = mem_stream.file,
+        .disable_colors = true,
+        .max_warns = 1,
+        .max_errors = 2
+    };
+    struct log children[2] = { log_create_child(&log), log_create_child(&log) };
+
+    struct file_loc loc1 = { .displayed_file_name = "a", .displayed_line = 1, .begin = { 1, 1 }, .end = { 1, 2 } };
+    struct file_loc loc2 = { .displayed_file_name = "a", .displayed_line = 2, .begin = { 2, 1 }, .end = { 2, 2 } };
+    log_error(&children[1], &loc1, "%d", 1);
+    log_error(&children[0], &loc2, "%d", 2);
+    log_note(&children[0], NULL, "%d", 3);
+    log_error(&children[0], &loc1, "%d", 4);
+    log_note(&children[0], NULL, "%d", 5);
+    log_warn(&children[1], &loc1, "%d", 6);
+    log_warn(&children[0], &loc1, "%d", 7);
+
+    REQUIRE(log.error_count == 3);
+    REQUIRE(log.warn_count == 2);
+    REQUIRE(children[0].error_count == 2);
+    REQUIRE(children[1].warn_count == 1);
+
+    log_merge(&log, children, 2);
+
+    // Messages of children merged later are separated from the messages already written.
+    log.max_errors = SIZE_MAX;
+    struct log child = log_create_child(&log);
+    log_error(&child, &loc1, "%d", 8);
+    log_merge(&log, &child, 1);
+    log_destroy(&child);
+
+    char* buf = mem_stream_release(&mem_stream);
+    static const char* result =
+        "error: 1\n"
+        "  in a(1:1 - 1:2)\n"
+        "\n"
+        "warning: 6\n"
+        "  in a(1:1 - 1:2)\n"
+        "\n"
+        "error: 2\n"
+        "  in a(2:1 - 2:2)\n"
+        "note: 3\n"
+        "\n"
+        "error: 8\n"
+        "  in a(1:1 - 1:2)\n";
+    REQUIRE(strcmp(buf, result) == 0);
+    free(buf);
+
+    log_destroy(&children[0]);
+    log_destroy(&children[1]);
+    log_destroy(&log);
+}
+
+TEST(log_json) {
+    struct mem_stream mem_stream;
+    mem_stream_init(&mem_stream);
+
+    struct line_reader line_reader = { .read_line = read_line };
+    struct log log = {
+        .file = mem_stream.file,
+        .max_warns = 1,
+        .max_errors = SIZE_MAX,
+        .line_reader = &line_reader,
+        .format = LOG_FORMAT_JSON
+    };
+
+    struct file_loc loc = { .displayed_file_name = "dir\\a.c", .displayed_line = 3, .begin = { 1, 5 }, .end = { 2, 6 } };
+    log_note(&log, NULL, "orphan");
+    log_error(&log, &loc, "unexpected \"%s\"\n", "tok\ten");
+    log_note(&log, NULL, "%d", 1);
+    log_note(&log, &loc, "%d", 2);
+    log_warn(&log, NULL, "%c", 1);
+    log_warn(&log, NULL, "skipped");
+    log_note(&log, NULL, "skipped");
+    log_error(&log, NULL, "last");
+    log_flush(&log);
+
+    // Notes of the parent must not be added to the records of its children.
+    struct log child = log_create_child(&log);
+    log_error(&child, NULL, "child");
+    log_merge(&log, &child, 1);
+    log_note(&log, NULL, "parent");
+    log_flush(&log);
+    log_destroy(&child);
+
+    // Notes must not be added to messages formatted as text.
+    log.defer_msgs = true;
+    log.disable_colors = true;
+    log.format = LOG_FORMAT_TEXT;
+    log_error(&log, NULL, "text");
+    log.format = LOG_FORMAT_JSON;
+    log_note(&log, NULL, "json");
+    log_flush(&log);
+
+    char* buf = mem_stream_release(&mem_stream);
+    static const char* result =
+        "{\"tag\":\"note\",\"message\":\"orphan\"}\n"
+        "{\"tag\":\"error\",\"file\":\"dir\\\\a.c\",\"begin\":{\"row\":3,\"col\":5},\"end\":{\"row\":4,\"col\":6},"
+            "\"message\":\"unexpected \\\"tok\\ten\\\"\\n\","
+            "\"notes\":[{\"tag\":\"note\",\"message\":\"1\"},"
+            "{\"tag\":\"note\",\"file\":\"dir\\\\a.c\",\"begin\":{\"row\":3,\"col\":5},\"end\":{\"row\":4,\"col\":6},\"message\":\"2\"}]}\n"
+        "{\"tag\":\"warning\",\"message\":\"\\u0001\"}\n"
+        "{\"tag\":\"error\",\"message\":\"last\"}\n"
+        "{\"tag\":\"error\",\"message\":\"child\"}\n"
+        "{\"tag\":\"note\",\"message\":\"parent\"}\n"
+        "error: text\n"
+        "{\"tag\":\"note\",\"message\":\"json\"}\n";
+    REQUIRE(strcmp(buf, result) == 0);
+    free(buf);
+    log_destroy(&log);
+}
+
+TEST(log_json_destroy) {
+    struct mem_stream mem_stream;
+    mem_stream_init(&mem_stream);
+
+    // The last record is written when the log is destroyed, even if it was never flushed.
+    struct log log = {
+        .file = mem_stream.file,
+        .max_warns = SIZE_MAX,
+        .max_errors = SIZE_MAX,
+        .format = LOG_FORMAT_JSON
+    };
+    log_error(&log, NULL, "last");
+    log_destroy(&log);
+
+    char* buf = mem_stream_release(&mem_stream);
+    REQUIRE(strcmp(buf, "{\"tag\":\"error\",\"message\":\"last\"}\n") == 0);
+    free(buf);
 }
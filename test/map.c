@@ -1,7 +1,12 @@
 #include <overture/test.h>
 #include <overture/map.h>
+#include <overture/minstd.h>
+#include <overture/str.h>
+
+#include <string.h>
 
 static inline uint32_t hash_int(uint32_t h, const int* i) { return hash_uint32(h, *i); }
+static inline uint32_t hash_sip_int(uint32_t h, const int* i) { return hash_sip_uint32(h, *i); }
 static inline bool is_int_equal(const int* i, const int* j) { return *i == *j; }
 
 MAP_DEFINE(int_map, int, int, hash_int, is_int_equal, PRIVATE)
@@ -23,3 +28,325 @@ TEST(map) {
         REQUIRE(!int_map_find(&int_map, &i));
     int_map_destroy(&int_map);
 }
+
+MAP_DEFINE_WITH_FLAGS(grouped_int_map, int, int, hash_int, is_int_equal, HASH_TABLE_GROUPED, PRIVATE)
+
+TEST(map_grouped) {
+    const int n = 10000;
+    struct grouped_int_map int_map = grouped_int_map_create();
+    for (int i = 0; i < n; ++i)
+        REQUIRE(grouped_int_map_insert(&int_map, &i, &i));
+    REQUIRE(!grouped_int_map_insert(&int_map, &(int) { 0 }, &(int) { 0 }));
+    REQUIRE(int_map.elem_count == (size_t)n);
+    for (int i = 0; i < n; ++i) {
+        REQUIRE(grouped_int_map_find(&int_map, &i));
+        REQUIRE(*grouped_int_map_find(&int_map, &i) == i);
+    }
+    for (int i = 0; i < n; i += 2)
+        REQUIRE(grouped_int_map_remove(&int_map, &i));
+    for (int i = 0; i < n; ++i)
+        REQUIRE((grouped_int_map_find(&int_map, &i) != NULL) == (i % 2 == 1));
+    size_t count = 0;
+    MAP_FOREACH(int, key, int, val, int_map) {
+        REQUIRE(*key == *val && *key % 2 == 1);
+        count++;
+    }
+    REQUIRE(count == int_map.elem_count);
+    for (int i = 1; i < n; i += 2)
+        REQUIRE(grouped_int_map_remove(&int_map, &i));
+    REQUIRE(int_map.elem_count == 0);
+    for (int i = 0; i < n; ++i)
+        REQUIRE(!grouped_int_map_find(&int_map, &i));
+    grouped_int_map_destroy(&int_map);
+}
+
+MAP_DEFINE_WITH_FLAGS(pow2_int_map, int, int, hash_int, is_int_equal, HASH_TABLE_POW2, PRIVATE)
+
+TEST(map_pow2) {
+    const int n = 10000;
+    struct pow2_int_map int_map = pow2_int_map_create();
+    for (int i = 0; i < n; ++i)
+        REQUIRE(pow2_int_map_insert(&int_map, &i, &i));
+    REQUIRE((int_map.hash_table.capacity & (int_map.hash_table.capacity - 1)) == 0);
+    for (int i = 0; i < n; ++i) {
+        REQUIRE(pow2_int_map_find(&int_map, &i));
+        REQUIRE(*pow2_int_map_find(&int_map, &i) == i);
+    }
+    for (int i = 0; i < n; ++i) {
+        REQUIRE(pow2_int_map_remove(&int_map, &i));
+        REQUIRE(!pow2_int_map_find(&int_map, &i));
+    }
+    REQUIRE(int_map.elem_count == 0);
+    pow2_int_map_destroy(&int_map);
+}
+
+TEST(map_stats) {
+    const int n = 10000;
+    struct int_map int_map = int_map_create();
+    for (int i = 0; i < n; ++i)
+        REQUIRE(int_map_insert(&int_map, &i, &i));
+    for (int i = 0; i < n; i += 3)
+        REQUIRE(int_map_remove(&int_map, &i));
+
+    // Robin Hood ordering: Distances can only increase by one from one bucket to the next.
+    const struct hash_table* hash_table = &int_map.hash_table;
+    for (size_t i = 0; i < hash_table->capacity; ++i) {
+        size_t j = hash_table_next_bucket(hash_table, i);
+        if (hash_table_is_bucket_occupied(hash_table, i) && hash_table_is_bucket_occupied(hash_table, j))
+            REQUIRE(hash_table_probe_distance(hash_table, j) <= hash_table_probe_distance(hash_table, i) + 1);
+    }
+
+    struct hash_table_stats stats = hash_table_stats(hash_table);
+    REQUIRE(stats.elem_count == int_map.elem_count);
+    REQUIRE(stats.capacity == hash_table->capacity);
+    REQUIRE(stats.max_probe_length >= 1);
+    REQUIRE(stats.mean_probe_length >= 1.0 && stats.mean_probe_length <= (double)stats.max_probe_length);
+    REQUIRE(stats.load_factor > 0.0 && stats.load_factor < 1.0);
+    int_map_destroy(&int_map);
+}
+
+MAP_DEFINE_WITH_FLAGS(incremental_int_map, int, int, hash_int, is_int_equal, HASH_TABLE_INCREMENTAL, PRIVATE)
+
+TEST(map_incremental) {
+    const int n = 10000;
+    struct incremental_int_map int_map = incremental_int_map_create();
+    bool was_migrating = false;
+    for (int i = 0; i < n; ++i) {
+        REQUIRE(incremental_int_map_insert(&int_map, &i, &i));
+        REQUIRE(!incremental_int_map_insert(&int_map, &i, &i));
+        if (!int_map.hash_table.old_table)
+            continue;
+
+        // Check lookups, removals, and iteration while the migration is in progress.
+        was_migrating = true;
+        REQUIRE(incremental_int_map_find(&int_map, &(int) { i / 2 }));
+        REQUIRE(*incremental_int_map_find(&int_map, &(int) { i / 2 }) == i / 2);
+        if (i % 7 == 0) {
+            REQUIRE(incremental_int_map_remove(&int_map, &(int) { i / 2 }));
+            REQUIRE(!incremental_int_map_find(&int_map, &(int) { i / 2 }));
+            REQUIRE(incremental_int_map_insert(&int_map, &(int) { i / 2 }, &(int) { i / 2 }));
+        }
+        if (i % 16 != 0)
+            continue;
+        size_t count = 0;
+        MAP_FOREACH(int, key, int, val, int_map) {
+            REQUIRE(*key == *val);
+            count++;
+        }
+        REQUIRE(count == int_map.elem_count);
+    }
+    REQUIRE(was_migrating);
+    REQUIRE(int_map.elem_count == (size_t)n);
+    for (int i = 0; i < n; ++i) {
+        REQUIRE(incremental_int_map_find(&int_map, &i));
+        REQUIRE(*incremental_int_map_find(&int_map, &i) == i);
+    }
+    for (int i = 0; i < n; ++i)
+        REQUIRE(incremental_int_map_remove(&int_map, &i));
+    REQUIRE(int_map.elem_count == 0);
+    REQUIRE(!int_map.hash_table.old_table);
+    incremental_int_map_destroy(&int_map);
+}
+
+TEST(map_many) {
+    enum { n = 1000 };
+    int keys[n], vals[n];
+    for (int i = 0; i < n; ++i) {
+        keys[i] = i;
+        vals[i] = i * 3;
+    }
+    struct int_map int_map = int_map_create();
+    REQUIRE(int_map_insert_many(&int_map, keys, vals, n / 2) == n / 2);
+    size_t capacity = int_map.hash_table.capacity;
+    REQUIRE(int_map_insert_many(&int_map, keys, vals, n) == n / 2);
+    REQUIRE(int_map.hash_table.capacity > capacity);
+    REQUIRE(int_map.elem_count == n);
+
+    const int* found_vals[n + 1];
+    int other_keys[n + 1];
+    for (int i = 0; i <= n; ++i)
+        other_keys[i] = n - i;
+    REQUIRE(int_map_find_many(&int_map, other_keys, found_vals, n + 1) == n);
+    REQUIRE(!found_vals[0]);
+    for (int i = 1; i <= n; ++i)
+        REQUIRE(found_vals[i] && *found_vals[i] == (n - i) * 3);
+    int_map_destroy(&int_map);
+}
+
+TEST(map_capacity) {
+    const int n = 1000;
+    struct int_map int_map = int_map_create();
+    int_map_reserve(&int_map, n);
+    size_t capacity = int_map.hash_table.capacity;
+    for (int i = 0; i < n; ++i)
+        REQUIRE(int_map_insert(&int_map, &i, &i));
+    REQUIRE(int_map.hash_table.capacity == capacity);
+
+    for (int i = 0; i < n - 10; ++i)
+        REQUIRE(int_map_remove(&int_map, &i));
+    REQUIRE(int_map.hash_table.capacity == capacity);
+    int_map_shrink_to_fit(&int_map);
+    REQUIRE(int_map.hash_table.capacity < 20);
+    for (int i = n - 10; i < n; ++i)
+        REQUIRE(*int_map_find(&int_map, &i) == i);
+
+    int_map_set_load_factors(&int_map, 20, 50);
+    for (int i = 0; i < n; ++i)
+        int_map_insert(&int_map, &i, &i);
+    REQUIRE(int_map.hash_table.capacity * 50 > (size_t)n * 100);
+    for (int i = 0; i < n - 10; ++i)
+        REQUIRE(int_map_remove(&int_map, &i));
+    REQUIRE(int_map.hash_table.capacity < 64);
+    for (int i = n - 10; i < n; ++i)
+        REQUIRE(*int_map_find(&int_map, &i) == i);
+    int_map_destroy(&int_map);
+}
+
+MAP_DEFINE_WITH_FLAGS(grouped_incremental_int_map, int, int, hash_int, is_int_equal, HASH_TABLE_GROUPED | HASH_TABLE_INCREMENTAL, PRIVATE)
+MAP_DEFINE_TRIVIAL(trivial_int_map, int, int, hash_int, PRIVATE)
+MAP_DEFINE_WITH_FLAGS(seeded_int_map, int, int, hash_sip_int, is_int_equal, HASH_TABLE_SEEDED | HASH_TABLE_INCREMENTAL, PRIVATE)
+MAP_DECL(trivial_grouped_incremental_int_map, int, int, PRIVATE)
+MAP_IMPL_TRIVIAL_WITH_FLAGS(trivial_grouped_incremental_int_map, int, int, hash_int, HASH_TABLE_GROUPED | HASH_TABLE_INCREMENTAL, PRIVATE)
+
+// Compares a random sequence of insertions, removals, and lookups against a reference model.
+#define FUZZ_MAP(name, min_load_factor) \
+    { \
+        enum { key_count = 512, op_count = 100000 }; \
+        int ref_vals[key_count]; \
+        bool is_present[key_count] = {}; \
+        size_t ref_count = 0; \
+        uint32_t state = 1; \
+        struct name map = name##_create(); \
+        if (min_load_factor > 0) \
+            name##_set_load_factors(&map, min_load_factor, 70); \
+        for (int op = 0; op < op_count; ++op) { \
+            uint32_t rand = minstd_gen(&state); \
+            int key = (rand >> 2) % key_count; \
+            if ((rand & 3) == 0) { \
+                REQUIRE(name##_insert(&map, &key, &op) == !is_present[key]); \
+                if (!is_present[key]) { \
+                    ref_vals[key] = op; \
+                    ref_count++; \
+                } \
+                is_present[key] = true; \
+            } else if ((rand & 3) == 1) { \
+                REQUIRE(name##_remove(&map, &key) == is_present[key]); \
+                ref_count -= is_present[key] ? 1 : 0; \
+                is_present[key] = false; \
+            } else { \
+                const int* val = name##_find(&map, &key); \
+                REQUIRE(is_present[key] ? val && *val == ref_vals[key] : !val); \
+            } \
+            REQUIRE(map.elem_count == ref_count); \
+        } \
+        size_t count = 0; \
+        MAP_FOREACH(int, key, int, val, map) { \
+            REQUIRE(is_present[*key] && ref_vals[*key] == *val); \
+            count++; \
+        } \
+        REQUIRE(count == ref_count); \
+        name##_destroy(&map); \
+    }
+
+TEST(map_seeded) {
+    struct int_map int_map = int_map_create();
+    REQUIRE(int_map.hash_table.seed == hash_init());
+    int_map_destroy(&int_map);
+
+    struct seeded_int_map map = seeded_int_map_create();
+    uint32_t seed = map.hash_table.seed;
+    for (int i = 0; i < 1000; ++i)
+        REQUIRE(seeded_int_map_insert(&map, &i, &i));
+    REQUIRE(map.hash_table.seed == seed);
+    for (int i = 0; i < 1000; ++i) {
+        REQUIRE(seeded_int_map_hash(&map, &i) == hash_sip_int(seed, &i));
+        REQUIRE(*seeded_int_map_find(&map, &i) == i);
+    }
+    seeded_int_map_destroy(&map);
+}
+
+TEST(map_fuzz) {
+    FUZZ_MAP(int_map, 0)
+    FUZZ_MAP(int_map, 20)
+    FUZZ_MAP(grouped_int_map, 0)
+    FUZZ_MAP(pow2_int_map, 10)
+    FUZZ_MAP(incremental_int_map, 0)
+    FUZZ_MAP(grouped_incremental_int_map, 30)
+    FUZZ_MAP(trivial_int_map, 0)
+    FUZZ_MAP(trivial_int_map, 20)
+    FUZZ_MAP(trivial_grouped_incremental_int_map, 30)
+    FUZZ_MAP(seeded_int_map, 20)
+}
+
+static inline uint32_t hash_str(uint32_t h, const char* const* str) { return hash_string(h, *str); }
+static inline bool is_str_equal(const char* const* str, const char* const* other) { return !strcmp(*str, *other); }
+static inline bool is_str_equal_to_view(const char* const* str, const struct str_view* view) {
+    return !strncmp(*str, view->data, view->length) && (*str)[view->length] == 0;
+}
+
+MAP_DEFINE(str_map, const char*, int, hash_str, is_str_equal, PRIVATE)
+MAP_DEFINE_FIND_AS(str_map, view, const char*, int, struct str_view, str_view_hash, is_str_equal_to_view, PRIVATE)
+
+TEST(map_with_hash) {
+    static const char* strs[] = { "foo", "bar", "foobar" };
+    struct str_map str_map = str_map_create();
+    for (int i = 0; i < 3; ++i) {
+        uint32_t hash = str_map_hash(&str_map, &strs[i]);
+        REQUIRE(!str_map_find_with_hash(&str_map, &strs[i], hash));
+        REQUIRE(str_map_insert_with_hash(&str_map, &strs[i], &i, hash));
+        REQUIRE(*str_map_find_with_hash(&str_map, &strs[i], hash) == i);
+    }
+    REQUIRE(*str_map_find_view(&str_map, &STR_VIEW("foo")) == 0);
+    REQUIRE(*str_map_find_view(&str_map, &(struct str_view) { .data = "foobar", .length = 6 }) == 2);
+    REQUIRE(!str_map_find_view(&str_map, &(struct str_view) { .data = "foobar", .length = 5 }));
+    str_map_destroy(&str_map);
+}
+
+TEST(map_find_or_insert) {
+    static const char* words[] = { "a", "b", "a", "c", "b", "a" };
+    struct str_map str_map = str_map_create();
+    for (size_t i = 0; i < sizeof(words) / sizeof(words[0]); ++i) {
+        bool inserted;
+        int* count = str_map_find_or_insert(&str_map, &words[i], &inserted);
+        if (inserted)
+            *count = 0;
+        (*count)++;
+    }
+    REQUIRE(str_map.elem_count == 3);
+    REQUIRE(*str_map_find(&str_map, &(const char*) { "a" }) == 3);
+    REQUIRE(*str_map_find(&str_map, &(const char*) { "b" }) == 2);
+    REQUIRE(*str_map_find(&str_map, &(const char*) { "c" }) == 1);
+    str_map_destroy(&str_map);
+
+    struct incremental_int_map int_map = incremental_int_map_create();
+    for (int i = 0; i < 1000; ++i) {
+        bool inserted;
+        *incremental_int_map_find_or_insert(&int_map, &i, &inserted) = i;
+        REQUIRE(inserted);
+        REQUIRE(*incremental_int_map_find_or_insert(&int_map, &(int) { i / 2 }, &inserted) == i / 2);
+        REQUIRE(!inserted);
+    }
+    REQUIRE(int_map.elem_count == 1000);
+    incremental_int_map_destroy(&int_map);
+}
+
+// Small tables must keep an empty bucket even when the maximum load factor is high.
+#define HIGH_LOAD_FACTOR_MAP(name) \
+    { \
+        struct name map = name##_create(); \
+        name##_set_load_factors(&map, 0, 90); \
+        for (int i = 0; i < 100; ++i) { \
+            REQUIRE(name##_insert(&map, &i, &i)); \
+            REQUIRE(map.elem_count < map.hash_table.capacity); \
+        } \
+        for (int i = 0; i < 200; ++i) \
+            REQUIRE(i < 100 ? *name##_find(&map, &i) == i : !name##_find(&map, &i)); \
+        name##_destroy(&map); \
+    }
+
+TEST(map_high_load_factor) {
+    HIGH_LOAD_FACTOR_MAP(int_map)
+    HIGH_LOAD_FACTOR_MAP(trivial_int_map)
+    HIGH_LOAD_FACTOR_MAP(grouped_incremental_int_map)
+    HIGH_LOAD_FACTOR_MAP(trivial_grouped_incremental_int_map)
+}
@@ -40,3 +40,56 @@ TEST(set) {
     free(elems);
     int_set_destroy(&int_set);
 }
+
+SET_DEFINE_WITH_FLAGS(grouped_pow2_int_set, int, hash_int, is_int_equal, HASH_TABLE_GROUPED | HASH_TABLE_POW2, PRIVATE)
+
+TEST(set_grouped_pow2) {
+    const int n = 10000;
+    struct grouped_pow2_int_set int_set = grouped_pow2_int_set_create();
+    for (int i = 0; i < n; ++i)
+        REQUIRE(grouped_pow2_int_set_insert(&int_set, &i));
+    for (int i = 0; i < n; ++i)
+        REQUIRE(grouped_pow2_int_set_find(&int_set, &i));
+    int sum = 0;
+    SET_FOREACH(int, elem, int_set)
+        sum += *elem;
+    REQUIRE(sum == n * (n - 1) / 2);
+    for (int i = 0; i < n; ++i) {
+        REQUIRE(grouped_pow2_int_set_remove(&int_set, &i));
+        REQUIRE(!grouped_pow2_int_set_find(&int_set, &i));
+    }
+    REQUIRE(int_set.elem_count == 0);
+    grouped_pow2_int_set_destroy(&int_set);
+}
+
+TEST(set_many) {
+    enum { n = 1000 };
+    int elems[n];
+    for (int i = 0; i < n; ++i)
+        elems[i] = i % (n / 2);
+    struct grouped_pow2_int_set int_set = grouped_pow2_int_set_create();
+    REQUIRE(grouped_pow2_int_set_insert_many(&int_set, elems, n) == n / 2);
+    REQUIRE(int_set.elem_count == n / 2);
+    const int* found_elems[n];
+    REQUIRE(grouped_pow2_int_set_find_many(&int_set, elems, found_elems, n) == n);
+    for (int i = 0; i < n; ++i)
+        REQUIRE(found_elems[i] && *found_elems[i] == elems[i]);
+    grouped_pow2_int_set_destroy(&int_set);
+}
+
+SET_DEFINE_TRIVIAL(trivial_int_set, int, hash_int, PRIVATE)
+
+TEST(set_trivial) {
+    const int n = 1000;
+    struct trivial_int_set set = trivial_int_set_create();
+    for (int i = 0; i < n; ++i)
+        REQUIRE(trivial_int_set_insert(&set, &i));
+    for (int i = 0; i < n; ++i)
+        REQUIRE(!trivial_int_set_insert(&set, &i));
+    for (int i = 0; i < n; i += 2)
+        REQUIRE(trivial_int_set_remove(&set, &i));
+    REQUIRE(set.elem_count == (size_t)n / 2);
+    for (int i = 0; i < n; ++i)
+        REQUIRE((trivial_int_set_find(&set, &i) != NULL) == (i % 2 == 1));
+    trivial_int_set_destroy(&set);
+}
@@ -1,5 +1,7 @@
 #include <overture/test.h>
 #include <overture/str.h>
+#include <overture/small_str.h>
+#include <overture/mem_pool.h>
 
 #include <stdio.h>
 #include <stdlib.h>
@@ -12,3 +14,105 @@ TEST(str) {
     REQUIRE(strcmp(str_terminate(&s), "Hello world!") == 0);
     str_destroy(&s);
 }
+
+TEST(str_printf_in_place) {
+    struct str s = str_create();
+    str_append(&s, STR_VIEW("abc"));
+    str_grow(&s, 16);
+    str_printf(&s, "%d", 42);
+    str_printf(&s, "%s", "!");
+    REQUIRE(s.length == 6);
+    REQUIRE(strcmp(str_terminate(&s), "abc42!") == 0);
+    str_destroy(&s);
+}
+
+TEST(small_str) {
+    struct small_str s;
+    small_str_init(&s, NULL);
+    small_str_printf(&s, "%s", "short");
+    REQUIRE(s.str.data == s.small_data);
+    REQUIRE(strcmp(small_str_terminate(&s), "short") == 0);
+    for (size_t i = 0; i < SMALL_STR_CAPACITY; ++i)
+        small_str_push(&s, 'x');
+    REQUIRE(s.str.data != s.small_data);
+    REQUIRE(s.str.length == SMALL_STR_CAPACITY + 5);
+    REQUIRE(!memcmp(s.str.data, "shortxxx", 8));
+    small_str_printf(&s, "%0*d", 1000, 7);
+    REQUIRE(s.str.length == SMALL_STR_CAPACITY + 1005);
+    REQUIRE(s.str.data[s.str.length - 1] == '7');
+    small_str_destroy(&s);
+
+    struct mem_pool mem_pool = mem_pool_create();
+    small_str_init(&s, &mem_pool);
+    for (size_t i = 0; i < 1000; ++i)
+        small_str_push(&s, (char)('a' + i % 26));
+    REQUIRE(s.str.data != s.small_data);
+    REQUIRE(s.str.length == 1000);
+    for (size_t i = 0; i < 1000; ++i)
+        REQUIRE(s.str.data[i] == (char)('a' + i % 26));
+    small_str_printf(&s, "%s", "!");
+    small_str_append(&s, STR_VIEW("?"));
+    REQUIRE(!memcmp(small_str_terminate(&s) + 998, "kl!?", 5));
+    small_str_destroy(&s);
+    mem_pool_destroy(&mem_pool);
+}
+
+static size_t naive_find(struct str_view str_view, struct str_view needle) {
+    for (size_t i = 0; i + needle.length <= str_view.length; ++i) {
+        if (!memcmp(str_view.data + i, needle.data, needle.length))
+            return i;
+    }
+    return STR_VIEW_NOT_FOUND;
+}
+
+TEST(str_view_find) {
+    char buf[200];
+    for (size_t i = 0; i < sizeof(buf); ++i)
+        buf[i] = "abc"[(i * 7 + i / 5) % 3];
+    for (size_t length = 0; length <= sizeof(buf); length += 13) {
+        struct str_view str_view = { .data = buf, .length = length };
+        for (char c = 'a'; c <= 'd'; ++c) {
+            size_t first = STR_VIEW_NOT_FOUND, last = STR_VIEW_NOT_FOUND;
+            for (size_t i = 0; i < length; ++i) {
+                if (buf[i] == c) {
+                    first = first == STR_VIEW_NOT_FOUND ? i : first;
+                    last = i;
+                }
+            }
+            REQUIRE(str_view_find_char(str_view, c) == first);
+            REQUIRE(str_view_find_last_char(str_view, c) == last);
+        }
+        for (size_t needle_start = 0; needle_start + 40 <= sizeof(buf); needle_start += 17) {
+            for (size_t needle_length = 0; needle_length <= 40; needle_length += 3) {
+                struct str_view needle = { .data = buf + needle_start, .length = needle_length };
+                REQUIRE(str_view_find(str_view, needle) == naive_find(str_view, needle));
+            }
+        }
+    }
+    REQUIRE(str_view_find(STR_VIEW("hello world"), STR_VIEW("world")) == 6);
+    REQUIRE(str_view_find(STR_VIEW("hello world"), STR_VIEW("word")) == STR_VIEW_NOT_FOUND);
+}
+
+TEST(str_view_split) {
+    static const char* parts[] = { "a", "", "bc", "" };
+    struct str_view_split split = str_view_split(STR_VIEW("a,,bc,"), ',');
+    struct str_view part;
+    size_t part_count = 0;
+    while (str_view_split_next(&split, &part)) {
+        REQUIRE(part_count < 4);
+        REQUIRE(str_view_is_equal(&part, &STR_VIEW(parts[part_count])));
+        part_count++;
+    }
+    REQUIRE(part_count == 4);
+
+    static const char* lines[] = { "first", "", "third", "last" };
+    struct str_view_lines line_iter = str_view_lines(STR_VIEW("first\n\r\nthird\nlast\n"));
+    struct str_view line;
+    size_t line_count = 0;
+    while (str_view_lines_next(&line_iter, &line)) {
+        REQUIRE(line_count < 4);
+        REQUIRE(str_view_is_equal(&line, &STR_VIEW(lines[line_count])));
+        line_count++;
+    }
+    REQUIRE(line_count == 4);
+}
@@ -1,8 +1,11 @@
 #include <overture/test.h>
 #include <overture/str_pool.h>
 #include <overture/mem_pool.h>
+#include <overture/map.h>
 
 #include <stdio.h>
+#include <string.h>
+#include <inttypes.h>
 
 TEST(str_pool) {
     struct mem_pool mem_pool = mem_pool_create();
@@ -29,3 +32,136 @@ TEST(str_pool) {
     str_pool_destroy(str_pool);
     mem_pool_destroy(&mem_pool);
 }
+
+MAP_DEFINE_TRIVIAL(pool_str_map, const char*, int, str_pool_hash_key, PRIVATE)
+
+TEST(str_pool_header) {
+    struct mem_pool mem_pool = mem_pool_create();
+    struct str_pool* str_pool = str_pool_create(&mem_pool);
+    struct pool_str_map map = pool_str_map_create();
+    const char* strs[100];
+    for (int i = 0; i < 100; ++i) {
+        char buf[16];
+        snprintf(buf, sizeof(buf), "str%d", i);
+        strs[i] = str_pool_insert(str_pool, buf);
+        REQUIRE(str_pool_length(strs[i]) == strlen(buf));
+        REQUIRE(str_pool_hash(strs[i]) == str_view_hash(hash_init(), &STR_VIEW(buf)));
+        struct str_view view = str_pool_view(strs[i]);
+        REQUIRE(str_view_is_equal(&STR_VIEW(buf), &view));
+        REQUIRE(pool_str_map_insert(&map, &strs[i], &i));
+    }
+    REQUIRE(str_pool_length(str_pool_insert(str_pool, "")) == 0);
+    for (int i = 0; i < 100; ++i) {
+        REQUIRE(str_pool_find_view(str_pool, str_pool_view(strs[i])) == strs[i]);
+        REQUIRE(*pool_str_map_find(&map, &strs[i]) == i);
+    }
+    pool_str_map_destroy(&map);
+    str_pool_destroy(str_pool);
+    mem_pool_destroy(&mem_pool);
+}
+
+TEST(str_pool_ids) {
+    struct mem_pool mem_pool = mem_pool_create();
+    struct str_pool* str_pool = str_pool_create(&mem_pool);
+    for (uint32_t i = 0; i < 100; ++i) {
+        char buf[16];
+        snprintf(buf, sizeof(buf), "str%"PRIu32, i);
+        const char* str = str_pool_insert(str_pool, buf);
+        REQUIRE(str_pool_insert(str_pool, buf) == str);
+        REQUIRE(str_pool_id(str) == i);
+        REQUIRE(str_pool_size(str_pool) == i + 1);
+    }
+    for (uint32_t i = 0; i < 100; ++i)
+        REQUIRE(str_pool_id(str_pool_from_id(str_pool, i)) == i);
+    REQUIRE(!strcmp(str_pool_from_id(str_pool, 42), "str42"));
+    str_pool_destroy(str_pool);
+    mem_pool_destroy(&mem_pool);
+}
+
+TEST(str_pool_snapshot) {
+    static const char* file_name = "str_pool_snapshot.bin";
+    struct mem_pool mem_pool = mem_pool_create();
+    struct str_pool* str_pool = str_pool_create(&mem_pool);
+    for (int i = 0; i < 1000; ++i) {
+        char buf[16];
+        snprintf(buf, sizeof(buf), "str%d", i);
+        (void)str_pool_insert(str_pool, buf);
+    }
+    (void)str_pool_insert(str_pool, "");
+    REQUIRE(str_pool_save(str_pool, file_name));
+    str_pool_destroy(str_pool);
+
+    struct str_pool_snapshot* snapshot = str_pool_snapshot_open(file_name);
+    REQUIRE(snapshot);
+    REQUIRE(str_pool_snapshot_size(snapshot) == 1001);
+    REQUIRE(str_pool_snapshot_find_view(snapshot, STR_VIEW("str42")));
+    REQUIRE(!str_pool_snapshot_find_view(snapshot, STR_VIEW("str1000")));
+
+    // Strings of the snapshot keep their ids, and new strings are numbered after them.
+    str_pool = str_pool_create_with_snapshot(&mem_pool, snapshot);
+    for (int i = 0; i < 2000; ++i) {
+        char buf[16];
+        snprintf(buf, sizeof(buf), "str%d", i);
+        const char* str = str_pool_insert(str_pool, buf);
+        REQUIRE(!strcmp(str, buf));
+        REQUIRE(str_pool_length(str) == strlen(buf));
+        REQUIRE(str_pool_hash(str) == str_view_hash(hash_init(), &STR_VIEW(buf)));
+        REQUIRE(str_pool_id(str) == (uint32_t)(i < 1000 ? i : i + 1));
+        REQUIRE(str_pool_from_id(str_pool, str_pool_id(str)) == str);
+        REQUIRE(str_pool_find(str_pool, buf) == str);
+    }
+    REQUIRE(str_pool_id(str_pool_find(str_pool, "")) == 1000);
+    REQUIRE(str_pool_size(str_pool) == 2001);
+
+    // Saving a pool created from a snapshot saves the strings of both.
+    REQUIRE(str_pool_save(str_pool, file_name));
+    str_pool_destroy(str_pool);
+    str_pool_snapshot_close(snapshot);
+    snapshot = str_pool_snapshot_open(file_name);
+    REQUIRE(snapshot);
+    REQUIRE(str_pool_snapshot_size(snapshot) == 2001);
+    REQUIRE(str_pool_id(str_pool_snapshot_find_view(snapshot, STR_VIEW("str1999"))) == 2000);
+    str_pool_snapshot_close(snapshot);
+
+    REQUIRE(!str_pool_snapshot_open("str_pool.c"));
+    remove(file_name);
+    mem_pool_destroy(&mem_pool);
+}
+
+TEST(str_pool_snapshot_corrupted) {
+    static const char* file_name = "str_pool_snapshot_corrupted.bin";
+    struct mem_pool mem_pool = mem_pool_create();
+    struct str_pool* str_pool = str_pool_create(&mem_pool);
+    (void)str_pool_insert(str_pool, "str");
+    REQUIRE(str_pool_save(str_pool, file_name));
+    str_pool_destroy(str_pool);
+
+    FILE* file = fopen(file_name, "rb");
+    REQUIRE(file);
+    char contents[4096];
+    size_t size = fread(contents, 1, sizeof(contents), file);
+    fclose(file);
+
+    // Fills the ids and the buckets of the hash index with offsets that lie past the end of the
+    // file. The header stores the offsets of those tables after the magic number and 4 counters.
+    uint64_t ids_offset, data_offset;
+    memcpy(&ids_offset, contents + 24, sizeof(uint64_t));
+    memcpy(&data_offset, contents + 40, sizeof(uint64_t));
+    REQUIRE(ids_offset < data_offset && data_offset < size);
+    memset(contents + ids_offset, 0x7F, data_offset - ids_offset);
+    file = fopen(file_name, "wb");
+    REQUIRE(file);
+    REQUIRE(fwrite(contents, 1, size, file) == size);
+    fclose(file);
+
+    struct str_pool_snapshot* snapshot = str_pool_snapshot_open(file_name);
+    REQUIRE(snapshot);
+    REQUIRE(!str_pool_snapshot_find_view(snapshot, STR_VIEW("str")));
+    str_pool = str_pool_create_with_snapshot(&mem_pool, snapshot);
+    REQUIRE(!str_pool_from_id(str_pool, 0));
+    str_pool_destroy(str_pool);
+    str_pool_snapshot_close(snapshot);
+
+    remove(file_name);
+    mem_pool_destroy(&mem_pool);
+}
@@ -0,0 +1,61 @@
+#include <overture/test.h>
+#include <overture/str_rope.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+TEST(str_rope) {
+    struct str_rope* rope = str_rope_create();
+    str_rope_append_view(rope, STR_VIEW("Hello"));
+    str_rope_append_copy(rope, STR_VIEW(", "));
+    str_rope_printf(rope, "%s %d", "world", 42);
+    struct str owned = str_create();
+    str_append(&owned, STR_VIEW("!"));
+    str_rope_append_str(rope, &owned);
+    REQUIRE(owned.data == NULL);
+    str_rope_append_copy(rope, STR_VIEW("?"));
+
+    // Consecutive copies share the same fragment.
+    REQUIRE(str_rope_fragment_count(rope) == 4);
+    REQUIRE(str_rope_length(rope) == strlen("Hello, world 42!?"));
+
+    struct str str = str_create();
+    str_append(&str, STR_VIEW(">"));
+    str_rope_flatten(rope, &str);
+    REQUIRE(strcmp(str_terminate(&str), ">Hello, world 42!?") == 0);
+    str_destroy(&str);
+
+    str_rope_clear(rope);
+    REQUIRE(str_rope_length(rope) == 0);
+    REQUIRE(str_rope_fragment_count(rope) == 0);
+    str_rope_destroy(rope);
+}
+
+TEST(str_rope_write) {
+    static const char* words[] = { "alpha ", "beta " };
+    struct str_rope* rope = str_rope_create();
+    struct str expected = str_create();
+    for (size_t i = 0; i < 5000; ++i) {
+        str_rope_append_view(rope, STR_VIEW(words[i % 2]));
+        str_append(&expected, STR_VIEW(words[i % 2]));
+        if (i % 7 == 0) {
+            str_rope_printf(rope, "%zu ", i);
+            str_printf(&expected, "%zu ", i);
+        }
+    }
+    REQUIRE(str_rope_fragment_count(rope) > 1024);
+
+    FILE* file = tmpfile();
+    REQUIRE(file);
+    REQUIRE(str_rope_write(rope, fileno(file)));
+    rewind(file);
+    char* data = malloc(expected.length + 1);
+    REQUIRE(fread(data, 1, expected.length + 1, file) == expected.length);
+    REQUIRE(!memcmp(data, expected.data, expected.length));
+    free(data);
+    fclose(file);
+
+    str_destroy(&expected);
+    str_rope_destroy(rope);
+}